@@ -5,6 +5,8 @@
 #include "env_related/base_env.h"
 #include "bur_related/bur_funcs.h"
 #include "bur_related/bur_tree.h"
+#include "bur_related/function_robot.h"
+#include <type_traits>
 
 #ifndef BASE_PLANNER_H
 #define BASE_PLANNER_H
@@ -20,75 +22,218 @@ namespace Burs
         Failure
     };
 
-    class BasePlanner
+    /// @brief Kinematics shared by all spikes of one bur: the centre's distal points are computed once
+    template <int DOF>
+    struct BurContextT
+    {
+        ConfigT<DOF> center;
+        Matrix<double, 3, DOF> center_points;
+        /// @brief Scratch for the distal points of the configuration being evaluated
+        Matrix<double, 3, DOF> points;
+        /// @brief Scratch for a block of spikes stepped together: their current configurations and distal points
+        Matrix<double, DOF, Dynamic> batch_q;
+        MatrixXd batch_points;
+        /// @brief Scratch for how far each distal point (row) of each spike (column) of the block moved
+        MatrixXd batch_distances;
+    };
+
+    using BurContext = BurContextT<Dynamic>;
+
+    class RobotBase;
+
+    /// @brief Bur planner for a robot with `DOF` joints
+    /// `DOF` fixes the size of every configuration so that the planning loops work on stack vectors,
+    /// `Dynamic` plans for any number of joints. `Robot` provides the kinematics, see `FunctionRobot`.
+    /// Instantiated for `Dynamic`, 7 and 9 with `FunctionRobot` and `RobotBase`.
+    template <int DOF, typename Robot = FunctionRobot<DOF>>
+    class BasePlannerT
     {
     public:
-        // BasePlanner() = default;
+        using Config = ConfigT<DOF>;
+        using Configs = Matrix<double, DOF, Dynamic>;
+        using Points = Matrix<double, 3, DOF>;
+        using Bur = BurT<DOF>;
+        using BurContext = BurContextT<DOF>;
 
-        BasePlanner(int q_dim,
-                    ForwardKinematics f,
-                    int max_iters,
-                    double d_crit,
-                    double delta_q,
-                    double epsilon_q,
-                    MatrixXd bounds,
-                    RadiusFunc radius_func,
-                    int num_spikes);
+        // BasePlanner() = default;
 
-        ~BasePlanner();
+        BasePlannerT(int q_dim,
+                     std::shared_ptr<Robot> robot,
+                     int max_iters,
+                     double d_crit,
+                     double delta_q,
+                     double epsilon_q,
+                     MatrixXd bounds,
+                     int num_spikes);
+
+        /// @brief Plan with kinematics callbacks, wrapped in a `FunctionRobot`
+        template <typename R = Robot, typename = std::enable_if_t<std::is_same_v<R, FunctionRobot<DOF>>>>
+        BasePlannerT(int q_dim,
+                     ForwardKinematicsT<DOF> f,
+                     int max_iters,
+                     double d_crit,
+                     double delta_q,
+                     double epsilon_q,
+                     MatrixXd bounds,
+                     RadiusFuncT<DOF> radius_func,
+                     int num_spikes)
+            : BasePlannerT(q_dim, std::make_shared<FunctionRobot<DOF>>(f, radius_func), max_iters, d_crit, delta_q, epsilon_q, bounds, num_spikes)
+        {
+        }
+
+        ~BasePlannerT();
 
         /// @brief maximum distance of any segment's movement between configuration points q1 and q2
         /// \rho_R(q_1, q_2) = \max_i |f_{p_i}(q_1) - f_{p_i}(q_2)|
-        double RhoR(const VectorXd &q1, const VectorXd &q2) const;
+        double RhoR(const Config &q1, const Config &q2) const;
+
+        /// @brief `RhoR(context.center, q)` reusing the centre's distal points
+        double RhoR(BurContext &context, const Config &q) const;
+
+        /// @brief Evaluate the distal points of the bur centre `q_near`
+        void InitBurContext(BurContext &context, const Config &q_near) const;
 
         /// @brief distance to closest obstacle
         /// \psi(t) = d_c - \rho_R(q, q + t(q_e - q))
         // PhiFunc GetPhiFunction(const double &d_closest, const VectorXd &q, const VectorXd &q_e) const;
-        double GetPhiFunction(const double &d_closest, const VectorXd &q, const VectorXd &q_e, const double &t) const;
+        double GetPhiFunction(const double &d_closest, const Config &q, const Config &q_e, const double &t) const;
 
         /// @brief parameter update to iterate to edge configuration
         // t_{k+1} = t_k + \frac{\psi(t_k)}{\sum_{i=1}^n r_i(t_k)|q_e_i - q_{k_i}|(1 - t_k)}
-        double GetDeltaTk(double phi_tk, double tk, const VectorXd &q_e, const VectorXd &q_k) const;
+        double GetDeltaTk(double phi_tk, double tk, const Config &q_e, const Config &q_k) const;
 
         /// @brief Get set of random configurations
-        MatrixXd GetRandomQ(const int &num_spikes) const;
+        Configs GetRandomQ(const int &num_spikes) const;
 
-        void GetEndpoints(MatrixXd &Qe, const VectorXd &q_near, double factor) const;
+        void GetEndpoints(Configs &Qe, const Config &q_near, double factor) const;
 
         /// @brief normalize spine to some length
         // q_{e_i} \leftarrow q_{near} + \delta \frac{q_{e_i} - q_{near}}{\| q_{e_i} - q_{near} \|}
-        VectorXd GetEndpoint(const VectorXd &q_ei, const VectorXd &q_near, double factor) const;
+        Config GetEndpoint(const Config &q_ei, const Config &q_near, double factor) const;
+
+        /// @brief `q_to - q_from` with the differences of continuous joints wrapped into [-pi, pi], the short way round
+        Config GetDelta(const Config &q_from, const Config &q_to) const;
 
         /// @brief Plan path using two opposing trees
         /// @return Matrix (q_dim, n), where n is the number of steps. OTHERWISE `VectorXd()` if planning fails
-        std::optional<std::vector<Eigen::VectorXd>> RbtConnect(const VectorXd &q_start, const VectorXd &q_goal);
+        std::optional<std::vector<Eigen::VectorXd>> RbtConnect(const Config &q_start, const Config &q_goal);
+
+        /// @brief Plan path by growing existing trees of the same cell, e.g. loaded snapshots
+        /// A query point that is not the root of its tree is connected into the tree and becomes its root;
+        /// if it cannot be connected, that side starts from a new tree instead.
+        std::optional<std::vector<Eigen::VectorXd>> RbtConnect(const Config &q_start, const Config &q_goal, std::shared_ptr<BurTree> t_start, std::shared_ptr<BurTree> t_goal);
+
+        /// @brief Trees grown by the last `RbtConnect`, e.g. to save them with `BurTree::Save`
+        std::shared_ptr<BurTree> GetStartTree() const;
+        std::shared_ptr<BurTree> GetGoalTree() const;
 
-        Vector3d ForwardEuclideanJoint(const int &ith_distal_point, const VectorXd &configuration) const;
+        Vector3d ForwardEuclideanJoint(const int &ith_distal_point, const Config &configuration) const;
 
         void SetBurEnv(std::shared_ptr<BaseEnv> bur_env);
 
+        std::shared_ptr<Robot> GetRobot() const;
+
+        /// @brief Replace the default all-points kinematics, which calls the per-point `ForwardKinematics` q_dim times
+        template <typename R = Robot>
+        std::enable_if_t<std::is_same_v<R, FunctionRobot<DOF>>> SetForwardKinematicsAll(ForwardKinematicsAllT<DOF> f_all)
+        {
+            this->robot->SetForwardKinematicsAll(f_all);
+        }
+
+        /// @brief Replace the default batch kinematics, which calls `ForwardKinematicsAll` once per configuration
+        template <typename R = Robot>
+        std::enable_if_t<std::is_same_v<R, FunctionRobot<DOF>>> SetForwardKinematicsBatch(ForwardKinematicsBatchT<DOF> f_batch)
+        {
+            this->robot->SetForwardKinematicsBatch(f_batch);
+        }
+
+        /// @brief Configuration-independent upper bounds of the protective radii, see `RobotBase::GetRadiusBounds`
+        /// With bounds set `GetBur` places every endpoint in closed form, t = d_closest / sum_i r_i |q_e_i - q_near_i|,
+        /// without kinematics; the burs are smaller but still collision free. `std::nullopt` restores the iteration.
+        void SetRadiusBounds(std::optional<Config> radius_bounds);
+
+        /// @brief Bound the motion of every distal point by the clearance of the links touching it instead of the global closest distance
+        /// Links far from the obstacles then no longer limit the bur, see `BaseEnv::GetPointClearances`
+        void SetPerLinkClearance(bool per_link_clearance);
+
+        /// @brief Upper limit of the endpoint iterations of one spike, a spike still moving after it keeps its last, shorter endpoint
+        void SetMaxBurIters(int max_bur_iters);
+
+        /// @brief Obstacle distances from `cap` on are not resolved exactly but reported as `cap`
+        /// Burs stay collision free, but none reaches further than a bur with clearance `cap`; keep `cap` above `d_crit`
+        void SetDistanceCap(double distance_cap);
+
+        /// @brief Number of threads `GetBur` evaluates spikes on, 0 for the OpenMP default
+        /// The kinematics and radius functions must then be safe to call concurrently, which `RobotBase` is;
+        /// other robots, e.g. `FunctionRobot` with user callbacks, default to a single thread
+        void SetBurThreads(int bur_threads);
+
+        /// @brief Nearest-neighbour settings of the trees grown by `RbtConnect`
+        /// The planner also moves the `continuous_joints` the short way round, so a path may end a multiple of 2 pi from the goal in them
+        void SetNNParams(NNParams nn_params);
+
+        /// @brief Number of closest tree nodes `BurConnect` tries before giving up as trapped
+        void SetConnectCandidates(int connect_candidates);
+
         std::vector<Eigen::VectorXd> Path(std::shared_ptr<BurTree> t_a, int a_closest, std::shared_ptr<BurTree> t_b, int b_closest);
 
-        AlgorithmState BurConnect(std::shared_ptr<BurTree> t, VectorXd &q);
-        bool IsColliding(const VectorXd &q);
-        double GetClosestDistance(const VectorXd &q);
-        VectorXd Nearest(std::shared_ptr<BurTree> t, VectorXd &q);
-        int NearestIndex(std::shared_ptr<BurTree> t, VectorXd &q);
-        Bur GetBur(const VectorXd &q_near, const MatrixXd &Q_e, double d_closest);
+        /// @brief Try to connect `q` to one of the `connect_candidates` nodes of `t` closest to it
+        /// @param connected_index index of the node of `t` that reached `q`
+        AlgorithmState BurConnect(std::shared_ptr<BurTree> t, Config &q, int &connected_index);
+        /// @brief Move from `q_start` towards `q` by burs until `q` is reached or the motion gets trapped
+        AlgorithmState BurConnectFrom(const Config &q_start, Config &q);
+        bool IsColliding(const Config &q);
+        /// @brief Whether the robot at `q` is closer than `threshold` to an obstacle, see `BaseEnv::IsWithinDistance`
+        bool IsWithinDistance(const Config &q, double threshold);
+        double GetClosestDistance(const Config &q);
+        /// @brief Obstacle clearance of every distal point at `q`
+        Config GetPointClearances(const Config &q);
+        /// @brief Closest obstacle distance of a tree node, cached in the tree
+        double GetNodeDistance(std::shared_ptr<BurTree> t, int index);
+        Config Nearest(std::shared_ptr<BurTree> t, const Config &q);
+        int NearestIndex(std::shared_ptr<BurTree> t, const Config &q);
+        Bur GetBur(const Config &q_near, const Configs &Q_e, double d_closest);
+        /// @brief Bur whose spikes move distal point i by less than `point_clearances[i]`
+        Bur GetBur(const Config &q_near, const Configs &Q_e, const Config &point_clearances);
         std::shared_ptr<BaseEnv> bur_env;
 
     private:
+        /// @brief Grow the trees, rooted at the start and the goal, towards each other until they connect
+        std::optional<std::vector<Eigen::VectorXd>> GrowTrees(std::shared_ptr<BurTree> t_start, std::shared_ptr<BurTree> t_goal);
+        /// @brief `t` rerooted at `q`, or a new tree at `q` if `q` cannot be connected to `t`
+        std::shared_ptr<BurTree> AttachRoot(std::shared_ptr<BurTree> t, const Config &q);
+
         int num_spikes;
-        RadiusFunc radius_func;
-        ForwardKinematics forwardKinematics;
+        std::shared_ptr<Robot> robot;
         int q_dim;
         MatrixXd bounds;
         int max_iters;
         double d_crit;
         double delta_q;
         double epsilon_q;
+        NNParams nn_params;
+        /// @brief Indices of the joints whose differences wrap around, see `NNParams::continuous_joints`
+        std::vector<int> continuous_joints;
+        int connect_candidates = 3;
+        int bur_threads = std::is_same_v<Robot, RobotBase> ? 0 : 1;
+        int max_bur_iters = 50;
+        double distance_cap = 1e14;
+        /// @brief Robot poses of the configuration being checked, the planner's own so that planners can share one environment
+        std::vector<RtModels::RtPose> robot_poses;
+        bool per_link_clearance = false;
+        std::optional<Config> radius_bounds;
+        std::shared_ptr<BurTree> start_tree;
+        std::shared_ptr<BurTree> goal_tree;
     };
 
+    using BasePlanner = BasePlannerT<Dynamic>;
+
+    extern template class BasePlannerT<Dynamic>;
+    extern template class BasePlannerT<7>;
+    extern template class BasePlannerT<9>;
+    extern template class BasePlannerT<Dynamic, RobotBase>;
+    extern template class BasePlannerT<7, RobotBase>;
+    extern template class BasePlannerT<9, RobotBase>;
 }
 
 #endif
\ No newline at end of file
@@ -13,9 +13,26 @@
 namespace Burs
 {
     using namespace Eigen;
-    using ForwardKinematics = std::function<Vector3d(const int &ith_distal_point, const VectorXd &configuration)>;
+    /// @brief Configuration of a robot with `DOF` joints, `Dynamic` when the number is only known at run time
+    template <int DOF>
+    using ConfigT = Matrix<double, DOF, 1>;
+
+    template <int DOF>
+    using ForwardKinematicsT = std::function<Vector3d(const int &ith_distal_point, const ConfigT<DOF> &configuration)>;
+    /// @brief Distal points 0..points.cols()-1 of `configuration` from a single pass, column i is `ForwardKinematics(i, configuration)`
+    template <int DOF>
+    using ForwardKinematicsAllT = std::function<void(const ConfigT<DOF> &configuration, Matrix<double, 3, DOF> &points)>;
+    /// @brief `ForwardKinematicsAll` of every column of `configurations`, rows 3i..3i+2 of `points` hold point i
+    template <int DOF>
+    using ForwardKinematicsBatchT = std::function<void(const Matrix<double, DOF, Dynamic> &configurations, MatrixXd &points)>;
+    template <int DOF>
+    using RadiusFuncT = std::function<double(const int &ith_distal_point, const ConfigT<DOF> &q_k)>;
+
+    using ForwardKinematics = ForwardKinematicsT<Dynamic>;
+    using ForwardKinematicsAll = ForwardKinematicsAllT<Dynamic>;
+    using ForwardKinematicsBatch = ForwardKinematicsBatchT<Dynamic>;
     using ForwardRt = std::function<std::tuple<std::vector<Matrix3d>, std::vector<Vector3d>>(VectorXd q)>;
-    using RadiusFunc = std::function<double(const int &ith_distal_point, const VectorXd &q_k)>;
+    using RadiusFunc = RadiusFuncT<Dynamic>;
 
     typedef double Meters;
     typedef double Qunit;
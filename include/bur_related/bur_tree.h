@@ -1,7 +1,13 @@
 #include <flann/flann.hpp>
 #include <Eigen/Dense>
 #include <memory>
+#include <algorithm>
+#include <tuple>
+#include <optional>
+#include <string>
+#include <limits>
 #include "bur_related/bur_funcs.h"
+#include "bur_related/nn_backend.h"
 
 #ifndef BUR_TREE_H
 #define BUR_TREE_H
@@ -10,18 +16,19 @@ namespace Burs
 {
     using namespace Eigen;
 
-    struct Bur
+    template <int DOF>
+    struct BurT
     {
-        VectorXd center;
-        MatrixXd endpoints;
-        Bur(VectorXd center, MatrixXd endpoints)
+        ConfigT<DOF> center;
+        Matrix<double, DOF, Dynamic> endpoints;
+        BurT(ConfigT<DOF> center, Matrix<double, DOF, Dynamic> endpoints)
             : center(center),
               endpoints(endpoints)
         {
         }
 
         // Overload the << operator to customize output
-        friend std::ostream &operator<<(std::ostream &out, const Bur &bur)
+        friend std::ostream &operator<<(std::ostream &out, const BurT &bur)
         {
             out << "Center: " << bur.center.transpose() << std::endl;
             out << "Endpoints:" << std::endl;
@@ -30,42 +37,57 @@ namespace Burs
         }
     };
 
-    struct RRTNode
-    {
-    public:
-        /// @brief Index of the node in the array
-        int parent_idx;
-
-        /// @brief Node location in configuration space
-        VectorXd q;
-
-        RRTNode(int p, VectorXd q)
-            : parent_idx(p),
-              q(q)
-        {
-        }
-    };
+    using Bur = BurT<Dynamic>;
 
     class BurTree
     {
     public:
-        BurTree(VectorXd q_location, int q_dim);
-        void AddNode(int p, VectorXd q_location);
-        int Nearest(double *new_point);
-        VectorXd GetQ(int index);
-        int GetParentIdx(int index);
-        int GetNumberOfNodes();
-        ~BurTree();
-
-        // friend std::ostream &operator<<(std::ostream &os, const BurTree &tree);
+        BurTree(VectorXd q_location, int q_dim, NNParams nn_params = NNParams());
+        void AddNode(int p, const Ref<const VectorXd> &q_location);
+        /// @brief Add every column of `q_locations` as a child of `p`, updating the index once
+        void AddNodes(int p, const MatrixXd &q_locations);
+        /// @brief Add `num_new` contiguous configurations as children of `p`, e.g. the columns of a fixed-size matrix
+        void AddNodes(int p, const double *q_locations, int num_new);
+        int Nearest(const double *new_point);
+        /// @brief Index of the closest node for every column of `queries` (q_dim, n), answered in one search
+        VectorXi NearestBatch(const MatrixXd &queries);
+        /// @brief Indices and distances of the `k` nodes closest to `q`, closest first
+        std::tuple<std::vector<int>, std::vector<double>> KNearest(const Ref<const VectorXd> &q, int k);
+        /// @brief Indices and distances of all nodes within distance `r` of `q`, closest first
+        std::tuple<std::vector<int>, std::vector<double>> RadiusSearch(const Ref<const VectorXd> &q, double r);
+        /// @brief View into the tree storage, invalidated by the next `AddNode(s)`
+        Map<const VectorXd> GetQ(int index) const;
+        int GetParentIdx(int index) const;
+        int GetNumberOfNodes() const;
+        /// @brief Index of the node without a parent
+        int GetRootIdx() const;
+        /// @brief Make `new_root` the root by reversing the edges on its way to the current root
+        void Reroot(int new_root);
+
+        /// @brief Closest obstacle distance of a node, if it has been computed
+        std::optional<double> GetDistance(int index) const;
+        void SetDistance(int index, double distance);
+
+        /// @brief Write a binary snapshot: configurations, parents and optionally the cached obstacle distances
+        /// Nodes are written breadth-first from the root, so their indices change once the tree has been rerooted.
+        /// The cached distances only hold while the obstacles stay where they were when the tree was grown;
+        /// save without them for a cell that changes, otherwise a reloaded tree builds burs into the moved obstacles.
+        void Save(const std::string &path, bool with_distances = true) const;
+
+        /// @brief Read a snapshot written by `Save` and rebuild the tree from it
+        /// @param q_dim number of joints the tree must have; the snapshot is rejected if it differs or its parents do not form a tree
+        static std::shared_ptr<BurTree> Load(const std::string &path, int q_dim, NNParams nn_params = NNParams());
+
+        ~BurTree() = default;
+
         friend std::ostream &operator<<(std::ostream &os, const BurTree &tree)
         {
-            for (const auto &node : tree.mNodes)
+            for (int i = 0; i < tree.GetNumberOfNodes(); ++i)
             {
-                os << node.parent_idx;
-                for (int j = 0; j < node.q.size(); ++j)
+                os << tree.mParents[i];
+                for (int j = 0; j < tree.mQDim; ++j)
                 {
-                    os << ", " << node.q[j];
+                    os << ", " << tree.mConfigs[i * tree.mQDim + j];
                 }
                 os << std::endl;
             }
@@ -73,39 +95,64 @@ namespace Burs
         }
 
     private:
-        std::vector<RRTNode> mNodes;
         int mQDim;
-        flann::Matrix<double> mData;
-        std::unique_ptr<flann::Index<flann::L2<double>>> mIndex;
 
-        void RefreshIndex()
-        {
-            this->mIndex = std::make_unique<flann::Index<flann::L2<double>>>(this->mData, flann::KDTreeIndexParams(4));
-            this->mIndex->buildIndex();
-        }
+        /// @brief Row-major node configurations, row `i` is node `i`. FLANN indexes this buffer directly.
+        std::vector<double> mConfigs;
+        /// @brief Parent index of each node, -1 for the root
+        std::vector<int> mParents;
+        /// @brief Closest obstacle distance of each node, NaN until computed
+        std::vector<double> mDistances;
+
+        NNParams mNNParams;
+        ConfigMetric mMetric;
+        std::unique_ptr<NNBackend> mIndex;
 
-        void BuildIndex()
+        static constexpr int kInitialCapacity = 64;
+
+        BurTree(int q_dim, NNParams nn_params, std::vector<double> configs, std::vector<int> parents, std::vector<double> distances);
+
+        /// @brief Pick the backend for the current tree size and index the whole storage
+        void RefreshIndex()
         {
-            this->RefreshDataFromNodes();
-            this->RefreshIndex();
+            int num_nodes = this->mParents.size();
+            if (num_nodes > this->mNNParams.linear_threshold)
+            {
+                this->mIndex = std::make_unique<FlannNNBackend>(this->mMetric, this->mNNParams.kd_trees, this->mNNParams.search_checks, this->mNNParams.search_cores);
+            }
+            else
+            {
+                this->mIndex = std::make_unique<LinearNNBackend>(this->mMetric);
+            }
+            this->mIndex->Build(this->mConfigs.data(), num_nodes, this->mQDim);
         }
 
-        void RefreshDataFromNodes()
+        /// @brief Append the configurations to the storage and register them in the index
+        void AppendNodes(int p, const double *q_locations, int num_new)
         {
-            // TODO: only update the last node
-            delete[] this->mData.ptr();
+            int first_new = this->mParents.size();
+            const double *old_data = this->mConfigs.data();
 
-            double *_data_mtx = new double[this->mNodes.size() * this->mQDim];
+            if (this->mConfigs.size() + num_new * this->mQDim > this->mConfigs.capacity())
+            {
+                size_t capacity = std::max(this->mConfigs.size() + num_new * this->mQDim, 2 * this->mConfigs.capacity());
+                this->mConfigs.reserve(std::max(capacity, (size_t)kInitialCapacity * this->mQDim));
+            }
+            this->mConfigs.insert(this->mConfigs.end(), q_locations, q_locations + num_new * this->mQDim);
+            this->mParents.insert(this->mParents.end(), num_new, p);
+            this->mDistances.insert(this->mDistances.end(), num_new, std::numeric_limits<double>::quiet_NaN());
 
-            this->mData = flann::Matrix<double>(_data_mtx, this->mNodes.size(), this->mQDim);
+            int num_nodes = this->mParents.size();
+            bool switch_backend = first_new <= this->mNNParams.linear_threshold && num_nodes > this->mNNParams.linear_threshold;
 
-            for (int i = 0; i < this->mNodes.size(); ++i)
+            // the index keeps pointers to the rows => moving the storage forces a rebuild, amortised by doubling
+            if (!this->mIndex || this->mConfigs.data() != old_data || switch_backend)
             {
-                for (int k = 0; k < this->mQDim; ++k)
-                {
-                    this->mData[i][k] = this->mNodes[i].q[k];
-                }
+                this->RefreshIndex();
+                return;
             }
+
+            this->mIndex->Extend(num_nodes);
         }
     };
 }
@@ -0,0 +1,96 @@
+#include <Eigen/Dense>
+#include "bur_related/bur_funcs.h"
+
+#ifndef FUNCTION_ROBOT_H
+#define FUNCTION_ROBOT_H
+
+namespace Burs
+{
+    using namespace Eigen;
+
+    /// @brief Kinematics policy of `BasePlannerT` built from callbacks
+    /// Any robot type with the same five methods, e.g. `RobotBase`, can be planned for directly, which lets the calls inline.
+    template <int DOF>
+    class FunctionRobot
+    {
+    public:
+        using Config = ConfigT<DOF>;
+        using Points = Matrix<double, 3, DOF>;
+        using Configs = Matrix<double, DOF, Dynamic>;
+
+        /// @brief The all-points and batch kinematics default to repeated calls of `f`
+        FunctionRobot(ForwardKinematicsT<DOF> f, RadiusFuncT<DOF> radius_func)
+            : forwardKinematics(f), radiusFunc(radius_func)
+        {
+        }
+
+        Vector3d GetForwardPoint(const int &ith_distal_point, const Config &configuration)
+        {
+            return this->forwardKinematics(ith_distal_point, configuration);
+        }
+
+        void GetForwardPoints(const Config &configuration, Points &points)
+        {
+            if (this->forwardKinematicsAll)
+            {
+                this->forwardKinematicsAll(configuration, points);
+                return;
+            }
+
+            for (int i = 0; i < points.cols(); ++i)
+            {
+                points.col(i) = this->forwardKinematics(i, configuration);
+            }
+        }
+
+        void GetForwardPointsBatch(const Configs &configurations, MatrixXd &points)
+        {
+            if (this->forwardKinematicsBatch)
+            {
+                this->forwardKinematicsBatch(configurations, points);
+                return;
+            }
+
+            Points column_points(3, points.rows() / 3);
+            for (int j = 0; j < configurations.cols(); ++j)
+            {
+                this->GetForwardPoints(configurations.col(j), column_points);
+                points.col(j) = Map<const VectorXd>(column_points.data(), column_points.size());
+            }
+        }
+
+        double GetRadius(const int &ith_distal_point, const Config &configuration)
+        {
+            return this->radiusFunc(ith_distal_point, configuration);
+        }
+
+        template <typename RadiiDerived>
+        void GetRadii(const Config &configuration, MatrixBase<RadiiDerived> &radii)
+        {
+            for (int i = 0; i < radii.size(); ++i)
+            {
+                radii(i) = this->radiusFunc(i, configuration);
+            }
+        }
+
+        /// @brief Replace the default all-points kinematics, `nullptr` restores it
+        void SetForwardKinematicsAll(ForwardKinematicsAllT<DOF> f_all)
+        {
+            this->forwardKinematicsAll = f_all;
+        }
+
+        /// @brief Replace the default batch kinematics, `nullptr` restores it
+        void SetForwardKinematicsBatch(ForwardKinematicsBatchT<DOF> f_batch)
+        {
+            this->forwardKinematicsBatch = f_batch;
+        }
+
+    private:
+        ForwardKinematicsT<DOF> forwardKinematics;
+        ForwardKinematicsAllT<DOF> forwardKinematicsAll;
+        ForwardKinematicsBatchT<DOF> forwardKinematicsBatch;
+        RadiusFuncT<DOF> radiusFunc;
+    };
+}
+
+#endif
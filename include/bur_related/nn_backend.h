@@ -0,0 +1,191 @@
+#include <flann/flann.hpp>
+#include <memory>
+#include <vector>
+#include <cmath>
+
+#ifndef NN_BACKEND_H
+#define NN_BACKEND_H
+
+namespace Burs
+{
+    struct NNParams
+    {
+        /// @brief Trees with at most this many nodes are searched by a linear scan instead of a KD-tree
+        int linear_threshold = 256;
+        /// @brief Number of leaves checked by the KD-tree search, `flann::FLANN_CHECKS_UNLIMITED` for an exact search
+        int search_checks = 128;
+        /// @brief Number of randomized KD-trees
+        int kd_trees = 4;
+        /// @brief Threads used by batched searches, 0 for all available cores
+        int search_cores = 0;
+        /// @brief Scale of each joint's difference in the search metric, empty for unweighted
+        std::vector<double> joint_weights;
+        /// @brief Joints whose difference wraps around at 2 pi, empty for none
+        std::vector<bool> continuous_joints;
+    };
+
+    /// @brief Squared weighted configuration distance used by the tree search, differences of continuous joints wrap into [-pi, pi]
+    struct ConfigMetric
+    {
+        typedef bool is_kdtree_distance;
+        typedef double ElementType;
+        typedef double ResultType;
+
+        std::vector<double> weights;
+        /// @brief 1.0 for continuous joints, 0.0 otherwise
+        std::vector<double> wrap;
+
+        ConfigMetric() = default;
+
+        ConfigMetric(int q_dim, const std::vector<double> &joint_weights, const std::vector<bool> &continuous_joints)
+            : weights(q_dim, 1.0), wrap(q_dim, 0.0)
+        {
+            for (int k = 0; k < q_dim; ++k)
+            {
+                if (k < (int)joint_weights.size())
+                {
+                    this->weights[k] = joint_weights[k];
+                }
+                if (k < (int)continuous_joints.size() && continuous_joints[k])
+                {
+                    this->wrap[k] = 1.0;
+                }
+            }
+        }
+
+        inline double Difference(double a, double b, int k) const
+        {
+            double diff = a - b;
+            if (this->wrap[k] != 0.0)
+            {
+                diff -= 2.0 * M_PI * std::round(diff / (2.0 * M_PI));
+            }
+            return this->weights[k] * diff;
+        }
+
+        template <typename Iterator1, typename Iterator2>
+        ResultType operator()(Iterator1 a, Iterator2 b, size_t size, ResultType worst_dist = -1) const
+        {
+            ResultType result = 0.0;
+            for (size_t k = 0; k < size; ++k)
+            {
+                double diff = this->Difference(a[k], b[k], k);
+                result += diff * diff;
+
+                if (worst_dist > 0 && result > worst_dist)
+                {
+                    return result;
+                }
+            }
+            return result;
+        }
+
+        /// @brief Contribution of dimension `k` to the distance from a KD-tree splitting plane
+        template <typename U, typename V>
+        ResultType accum_dist(const U &a, const V &b, int k) const
+        {
+            // the far side of the plane may wrap around arbitrarily close, 0 keeps the bound valid
+            if (this->wrap[k] != 0.0)
+            {
+                return 0.0;
+            }
+            double diff = this->weights[k] * (a - b);
+            return diff * diff;
+        }
+    };
+
+    /// @brief Result buffers kept between queries so that searching does not allocate
+    struct NNQueryContext
+    {
+        std::vector<int> indices;
+        std::vector<double> dists;
+
+        void Reserve(size_t num_results)
+        {
+            if (this->indices.size() < num_results)
+            {
+                this->indices.resize(num_results);
+                this->dists.resize(num_results);
+            }
+        }
+    };
+
+    /// @brief Nearest-neighbour search over a row-major (num_rows, q_dim) configuration buffer owned by the caller
+    class NNBackend
+    {
+    public:
+        virtual ~NNBackend() = default;
+
+        /// @brief Index the first `num_rows` rows of `data`
+        virtual void Build(const double *data, int num_rows, int q_dim) = 0;
+
+        /// @brief Index rows appended to the buffer passed to `Build`, `num_rows` is the new total
+        virtual void Extend(int num_rows) = 0;
+
+        /// @brief Row index of the point closest to `q`
+        virtual int Nearest(const double *q) = 0;
+
+        /// @brief Row index of the closest point for each of the `num_queries` row-major `queries`
+        virtual void NearestBatch(const double *queries, int num_queries, int *closest) = 0;
+
+        /// @brief Up to `k` closest rows to `q` and their distances, closest first
+        virtual void KNearest(const double *q, int k, std::vector<int> &indices, std::vector<double> &dists) = 0;
+
+        /// @brief All rows closer to `q` than `radius` and their distances, closest first
+        virtual void RadiusSearch(const double *q, double radius, std::vector<int> &indices, std::vector<double> &dists) = 0;
+    };
+
+    /// @brief Exact search by scanning every row, faster than a KD-tree for small trees
+    class LinearNNBackend : public NNBackend
+    {
+    public:
+        LinearNNBackend(ConfigMetric metric);
+
+        void Build(const double *data, int num_rows, int q_dim) override;
+        void Extend(int num_rows) override;
+        int Nearest(const double *q) override;
+        void NearestBatch(const double *queries, int num_queries, int *closest) override;
+        void KNearest(const double *q, int k, std::vector<int> &indices, std::vector<double> &dists) override;
+        void RadiusSearch(const double *q, double radius, std::vector<int> &indices, std::vector<double> &dists) override;
+
+    private:
+        ConfigMetric mMetric;
+        const double *mData = nullptr;
+        int mRows = 0;
+        int mQDim = 0;
+
+        double SquaredDistance(const double *a, const double *b) const;
+    };
+
+    /// @brief Randomized KD-tree search, approximate unless the number of checks is unlimited
+    class FlannNNBackend : public NNBackend
+    {
+    public:
+        FlannNNBackend(ConfigMetric metric, int kd_trees, int search_checks, int search_cores);
+
+        void Build(const double *data, int num_rows, int q_dim) override;
+        void Extend(int num_rows) override;
+        int Nearest(const double *q) override;
+        void NearestBatch(const double *queries, int num_queries, int *closest) override;
+        void KNearest(const double *q, int k, std::vector<int> &indices, std::vector<double> &dists) override;
+        void RadiusSearch(const double *q, double radius, std::vector<int> &indices, std::vector<double> &dists) override;
+
+    private:
+        ConfigMetric mMetric;
+        int mKdTrees;
+        int mSearchChecks;
+        int mSearchCores;
+        NNQueryContext mQuery;
+        std::vector<std::vector<int>> mRadiusIndices;
+        std::vector<std::vector<double>> mRadiusDists;
+        double *mData = nullptr;
+        int mRows = 0;
+        int mQDim = 0;
+        std::unique_ptr<flann::Index<ConfigMetric>> mIndex;
+
+        /// @brief FLANN rebuilds its trees once the index has grown by this factor since the last build
+        static constexpr float kRebuildThreshold = 2.0f;
+    };
+}
+
+#endif
@@ -7,11 +7,71 @@
 
 namespace Burs
 {
+    /// @brief Planner calling the robot's kinematics directly instead of through callbacks
+    /// The joint count is only known once the URDF is read, so the fixed-size instantiations hide behind this interface.
+    class URDFBasePlanner
+    {
+    public:
+        virtual ~URDFBasePlanner() = default;
+
+        virtual std::optional<std::vector<Eigen::VectorXd>> RbtConnect(const Eigen::VectorXd &q_start, const Eigen::VectorXd &q_goal) = 0;
+        virtual void SetBurEnv(std::shared_ptr<BaseEnv> bur_env) = 0;
+        virtual void SetNNParams(NNParams nn_params) = 0;
+        virtual void SetRadiusBounds(std::optional<Eigen::VectorXd> radius_bounds) = 0;
+        virtual void SetDistanceCap(double distance_cap) = 0;
+        virtual void SetPerLinkClearance(bool per_link_clearance) = 0;
+    };
+
+    /// @brief `URDFBasePlanner` over `BasePlannerT<DOF, RobotBase>`
+    template <int DOF>
+    class URDFBasePlannerT : public URDFBasePlanner
+    {
+    public:
+        using Planner = BasePlannerT<DOF, RobotBase>;
+
+        URDFBasePlannerT(int q_dim, std::shared_ptr<RobotBase> robot, int max_iters, double d_crit, double delta_q, double epsilon_q, MatrixXd bounds, int num_spikes)
+            : planner(q_dim, robot, max_iters, d_crit, delta_q, epsilon_q, bounds, num_spikes)
+        {
+        }
+
+        std::optional<std::vector<Eigen::VectorXd>> RbtConnect(const Eigen::VectorXd &q_start, const Eigen::VectorXd &q_goal) override
+        {
+            return this->planner.RbtConnect(typename Planner::Config(q_start), typename Planner::Config(q_goal));
+        }
+
+        void SetBurEnv(std::shared_ptr<BaseEnv> bur_env) override
+        {
+            this->planner.SetBurEnv(bur_env);
+        }
+
+        void SetNNParams(NNParams nn_params) override
+        {
+            this->planner.SetNNParams(nn_params);
+        }
+
+        void SetRadiusBounds(std::optional<Eigen::VectorXd> radius_bounds) override
+        {
+            this->planner.SetRadiusBounds(radius_bounds ? std::optional<typename Planner::Config>(*radius_bounds) : std::nullopt);
+        }
+
+        void SetDistanceCap(double distance_cap) override
+        {
+            this->planner.SetDistanceCap(distance_cap);
+        }
+
+        void SetPerLinkClearance(bool per_link_clearance) override
+        {
+            this->planner.SetPerLinkClearance(per_link_clearance);
+        }
+
+        Planner planner;
+    };
+
     class URDFPlanner
     {
     public:
         std::shared_ptr<CollisionEnv> mCollisionEnv;
-        std::shared_ptr<BasePlanner> mBasePlanner;
+        std::shared_ptr<URDFBasePlanner> mBasePlanner;
 
         URDFPlanner(std::string urdf_file, int max_iters, double d_crit, double delta_q, double epsilon_q, int num_spikes);
 
@@ -27,6 +87,22 @@ namespace Burs
         void
         SetObstacleRotation(int id, Eigen::Matrix3d R, Eigen::Vector3d t);
 
+        /// @brief Build burs from precomputed radius bounds instead of iterating the kinematics, see `BasePlannerT::SetRadiusBounds`
+        void
+        SetUseRadiusBounds(bool use_radius_bounds);
+
+        /// @brief Stop resolving obstacle distances beyond `distance_cap`, see `BasePlannerT::SetDistanceCap`
+        void
+        SetDistanceCap(double distance_cap);
+
+        /// @brief Spread the robot × obstacle distance queries over `distance_threads` threads, see `BaseEnv::SetDistanceThreads`
+        void
+        SetDistanceThreads(int distance_threads);
+
+        /// @brief Bound every link's motion by its own obstacle distance, see `BasePlannerT::SetPerLinkClearance`
+        void
+        SetPerLinkClearance(bool per_link_clearance);
+
         std::string
         ToString(const Eigen::VectorXd &q_in);
 
@@ -1,6 +1,7 @@
 #include "bur_related/burs.h"
 
 #include <memory>
+#include <tuple>
 #include <vector>
 #include <Eigen/Dense>
 #include "model_related/rt_model.h"
@@ -23,11 +24,43 @@ namespace Burs
         */
 
         void SetPoses(VectorXd q);
-        void AddRobotModel(std::shared_ptr<RtModels::RtModel> m);
+        /// @param segment_id chain segment the model is attached to, -1 if unknown
+        void AddRobotModel(std::shared_ptr<RtModels::RtModel> m, int segment_id = -1);
         void AddForwardRt(Burs::ForwardRt forwardRt);
         /// @brief Check closest distance between robot parts and obstacles, NEED TO SET ROTATIONS AND TRANSLATIONS BEFOREHAND
-        double GetClosestDistance() const;
+        /// Pairs are resolved in the order of their bounding-volume lower bounds until no remaining pair can be closer.
+        /// @param cap distances of at least `cap` are not resolved, the result is then `cap`
+        double GetClosestDistance(double cap = 1e14) const;
+        /// @brief Closest distance of every robot model to the obstacles, in the order of `robot_models`, capped like `GetClosestDistance`
+        VectorXd GetClosestDistances(double cap = 1e14) const;
+        /// @brief Clearance of each of the first `num_points` distal points: the smallest distance of the robot models touching it
+        /// The model of segment s spans distal points s + 1 and s + 2, models beyond the last point bound the last point;
+        /// models without a segment bound every point
+        VectorXd GetPointClearances(int num_points, double cap = 1e14) const;
         bool IsColliding() const;
+        /// @brief Number of threads `GetClosestDistance` resolves pairs on, 1 evaluates them in turn
+        /// Queries leave the shared models untouched, so pairs sharing a robot link or an obstacle run concurrently as well
+        void SetDistanceThreads(int distance_threads);
+        /// @brief Whether some robot part is closer than `threshold` to an obstacle, NEED TO SET ROTATIONS AND TRANSLATIONS BEFOREHAND
+        /// Cheaper than `GetClosestDistance` when only the comparison matters: stops at the first such pair
+        bool IsWithinDistance(double threshold) const;
+        /// @brief Broad phase: robot × obstacle pairs (robot model, obstacle model) whose world boxes are at most `margin` apart
+        /// Sweep and prune along x, every other pair is provably farther than `margin`
+        std::vector<std::pair<int, int>> GetCandidatePairs(double margin = 0) const;
+
+        // The queries below take the robot poses from the caller instead of the shared models. They only read the
+        // environment, so any number of threads can query it concurrently, each with its own pose buffer, as long as
+        // nobody sets poses or moves obstacles meanwhile. PQP's warm starts are kept in the pose buffer as well.
+
+        /// @brief Poses of the robot models at configuration `q`, written into the caller's `robot_poses`
+        void ComputePoses(const VectorXd &q, std::vector<RtModels::RtPose> &robot_poses) const;
+        double GetClosestDistance(const std::vector<RtModels::RtPose> &robot_poses, double cap = 1e14) const;
+        VectorXd GetClosestDistances(const std::vector<RtModels::RtPose> &robot_poses, double cap = 1e14) const;
+        VectorXd GetPointClearances(const std::vector<RtModels::RtPose> &robot_poses, int num_points, double cap = 1e14) const;
+        bool IsColliding(const std::vector<RtModels::RtPose> &robot_poses) const;
+        bool IsWithinDistance(const std::vector<RtModels::RtPose> &robot_poses, double threshold) const;
+        std::vector<std::pair<int, int>> GetCandidatePairs(const std::vector<RtModels::RtPose> &robot_poses, double margin = 0) const;
+
         /*If you want to add other robots, make an environment for them and add the other robot as an obstacle to this one.*/
         int
         AddObstacle(std::string obstacle_file, Eigen::Matrix3d R = Eigen::Matrix3d::Identity(), Eigen::Vector3d t = Eigen::Vector3d::Zero());
@@ -37,10 +70,22 @@ namespace Burs
 
         std::vector<std::shared_ptr<RtModels::RtModel>> obstacle_models;
         std::vector<std::shared_ptr<RtModels::RtModel>> robot_models;
+        /// @brief Chain segment of every robot model, -1 if unknown
+        std::vector<int> robot_model_segments;
         std::vector<std::string> obstacle_map;
 
     private:
+        /// @brief `GetClosestDistance` over `pairs` sorted by lower bound, with the pairs spread over `distance_threads` threads
+        double GetClosestDistanceParallel(const std::vector<RtModels::RtPose> &robot_poses, const std::vector<std::tuple<double, int, int>> &pairs, double cap) const;
+
+        /// @brief Warm start of robot model `i` against obstacle `k` kept in the caller's poses, none if the poses predate the obstacle
+        static RtModels::RtWarmStart *WarmStart(const std::vector<RtModels::RtPose> &robot_poses, int i, int k);
+
+        /// @brief Robot poses of the last `SetPoses`, used by the queries without a pose buffer
+        std::vector<RtModels::RtPose> robot_poses;
+
         bool poses_are_set = false;
+        int distance_threads = 1;
         Burs::ForwardRt forwardRt;
     };
 }
@@ -1,6 +1,8 @@
 #include <string>
 #include <Eigen/Dense>
+#include <Eigen/Geometry>
 #include <memory>
+#include <vector>
 #include "PQP.h"
 
 #ifndef RT_MODEL_H
@@ -8,6 +10,26 @@
 
 namespace RtModels
 {
+    /// @brief Closest triangles of the last distance query of a model pair, where PQP starts the next query of the pair
+    struct RtWarmStart
+    {
+        const Tri *tri1 = nullptr;
+        const Tri *tri2 = nullptr;
+    };
+
+    /// @brief Placement of a model in the world together with its world-space bounding volumes
+    /// Kept apart from the geometry so that a caller can query one shared model at its own poses
+    struct RtPose
+    {
+        PQP_REAL rotation[3][3];
+        PQP_REAL translation[3];
+        Eigen::Vector3d center = Eigen::Vector3d::Zero();
+        Eigen::AlignedBox3d box;
+        /// @brief Warm start against every obstacle, updated by the distance queries at this pose
+        /// A pose set has a single owner, so queries update it through const poses.
+        mutable std::vector<RtWarmStart> warm_starts;
+    };
+
     class RtModel
     {
     public:
@@ -17,8 +39,8 @@ namespace RtModels
         // Public member functions (e.g., setters and getters) can be added as needed
 
         // Public member variables
-        Eigen::Matrix<PQP_REAL, 3, 3> R;     // Rotation matrix
-        Eigen::Matrix<PQP_REAL, 3, 1> t;     // Translation vector
+        Eigen::Matrix<PQP_REAL, 3, 3> R = Eigen::Matrix<PQP_REAL, 3, 3>::Identity(); // Rotation matrix
+        Eigen::Matrix<PQP_REAL, 3, 1> t = Eigen::Matrix<PQP_REAL, 3, 1>::Zero();     // Translation vector
         std::shared_ptr<PQP_Model> pqpModel; // Pointer to PQP_Model which is collidable
         std::string filePath;
 
@@ -40,6 +62,26 @@ namespace RtModels
         /// @brief Intance-wise collision check
         void Collide(PQP_CollideResult *result, RtModel *m2);
 
+        /// @brief Intance-wise check whether the distance is below `tolerance`
+        void CheckTolerance(PQP_ToleranceResult *result, PQP_REAL tolerance, RtModel *m2);
+
+        /// @brief Pose of the model at rotation `rotation` and translation `tr`, written into the caller's `pose`
+        void ComputePose(const Eigen::Matrix3d &rotation, const Eigen::Vector3d &tr, RtPose &pose) const;
+
+        /// @brief The model's own pose, kept up to date by the setters
+        const RtPose &GetPose() const;
+
+        /// @brief Lower bound of the distance between the meshes of two models at the given poses
+        /// Taken from their bounding spheres and world boxes, costs no BVH traversal
+        static double LowerBoundDistance(const RtModel &m1, const RtPose &p1, const RtModel &m2, const RtPose &p2);
+
+        // Queries at caller-owned poses, they leave the models untouched and may run concurrently on shared models.
+        // PQP runs on per-query copies of the models that share the triangles and the BVH, so the warm-start
+        // triangle it writes lands in the copy; `CheckDistance` hands it to the caller through `warm_start`.
+        static void CheckDistance(PQP_DistanceResult *result, PQP_REAL rel_err, PQP_REAL abs_err, const RtModel &m1, const RtPose &p1, const RtModel &m2, const RtPose &p2, RtWarmStart *warm_start = nullptr);
+        static void Collide(PQP_CollideResult *result, const RtModel &m1, const RtPose &p1, const RtModel &m2, const RtPose &p2);
+        static void CheckTolerance(PQP_ToleranceResult *result, PQP_REAL tolerance, const RtModel &m1, const RtPose &p1, const RtModel &m2, const RtPose &p2);
+
         static void CheckDistanceStatic(PQP_DistanceResult *result, PQP_REAL rel_err, PQP_REAL abs_err, RtModel *m1, RtModel *m2);
         static void CollideStatic(PQP_CollideResult *result, RtModel *m1, RtModel *m2);
 
@@ -50,8 +92,12 @@ namespace RtModels
 
     private:
         // std::string filePath;
-        PQP_REAL rotation[3][3];
-        PQP_REAL translation[3];
+        RtPose pose;
+
+        // bounding volumes of the mesh in its own frame
+        Eigen::Vector3d local_center = Eigen::Vector3d::Zero();
+        Eigen::Vector3d local_half_extents = Eigen::Vector3d::Zero();
+        double local_radius = 0;
     };
 
 }
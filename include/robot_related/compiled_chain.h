@@ -0,0 +1,203 @@
+#include <vector>
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+
+#ifndef COMPILED_CHAIN_H
+#define COMPILED_CHAIN_H
+
+namespace KDL
+{
+    class Chain;
+}
+
+namespace Burs
+{
+    enum class JointKind
+    {
+        Fixed,
+        Revolute,
+        Prismatic
+    };
+
+    /// @brief One chain segment: pose(q) = [R(axis, q) | origin] * tip for revolute, [I | origin + q * axis] * tip for prismatic joints
+    struct CompiledSegment
+    {
+        JointKind kind;
+        /// @brief Index of the joint in the configuration, -1 for fixed segments
+        int joint_index;
+        /// @brief Joint axis in the frame of the parent segment
+        Eigen::Vector3d axis;
+        Eigen::Vector3d origin;
+        Eigen::Isometry3d tip;
+    };
+
+    /// @brief Flat copy of a `KDL::Chain` for fast forward kinematics
+    class CompiledChain
+    {
+    public:
+        CompiledChain() = default;
+        explicit CompiledChain(const KDL::Chain &kdl_chain);
+
+        int GetNrOfSegments() const
+        {
+            return this->segments.size();
+        }
+
+        int GetNrOfJoints() const
+        {
+            return this->num_joints;
+        }
+
+        const CompiledSegment &GetSegment(int i) const
+        {
+            return this->segments[i];
+        }
+
+        /// @brief Pose of segment `i` relative to the previous one
+        template <typename Derived>
+        Eigen::Isometry3d SegmentPose(int i, const Eigen::MatrixBase<Derived> &q) const
+        {
+            const CompiledSegment &segment = this->segments[i];
+            Eigen::Isometry3d pose;
+
+            switch (segment.kind)
+            {
+            case JointKind::Revolute:
+            {
+                Eigen::Matrix3d R = Eigen::AngleAxisd(q(segment.joint_index), segment.axis).toRotationMatrix();
+                pose.linear() = R * segment.tip.linear();
+                pose.translation() = R * segment.tip.translation() + segment.origin;
+                break;
+            }
+            case JointKind::Prismatic:
+                pose.linear() = segment.tip.linear();
+                pose.translation() = segment.tip.translation() + segment.origin + q(segment.joint_index) * segment.axis;
+                break;
+            default:
+                pose = segment.tip;
+                break;
+            }
+            pose.makeAffine();
+            return pose;
+        }
+
+        /// @brief frames[i] is the pose after the first i segments, frames[0] the base
+        template <typename Derived>
+        void Forward(const Eigen::MatrixBase<Derived> &q, std::vector<Eigen::Isometry3d> &frames) const
+        {
+            frames.resize(this->segments.size() + 1);
+            frames[0].setIdentity();
+
+            for (size_t i = 0; i < this->segments.size(); ++i)
+            {
+                frames[i + 1] = frames[i] * this->SegmentPose(i, q);
+            }
+        }
+
+        /// @brief Position after the first `num_segments` segments
+        template <typename Derived>
+        Eigen::Vector3d ForwardPoint(int num_segments, const Eigen::MatrixBase<Derived> &q) const
+        {
+            Eigen::Isometry3d frame = Eigen::Isometry3d::Identity();
+            for (int i = 0; i < num_segments; ++i)
+            {
+                frame = frame * this->SegmentPose(i, q);
+            }
+            return frame.translation();
+        }
+
+        /// @brief Column i of `points` is the position after the first i segments
+        template <typename Derived, typename PointsDerived>
+        void ForwardPoints(const Eigen::MatrixBase<Derived> &q, Eigen::MatrixBase<PointsDerived> &points) const
+        {
+            Eigen::Isometry3d frame = Eigen::Isometry3d::Identity();
+            for (int i = 0; i < points.cols(); ++i)
+            {
+                points.col(i) = frame.translation();
+                if (i < (int)this->segments.size())
+                {
+                    frame = frame * this->SegmentPose(i, q);
+                }
+            }
+        }
+
+        /// @brief `ForwardPoints` of `num_configs` configurations at once, four of them per SIMD register
+        /// @param configs column-major (joints, num_configs), one configuration per column
+        /// @param points column-major (3 * num_points, num_configs), rows 3i..3i+2 hold point i
+        void ForwardPointsBatch(const double *configs, int num_configs, int num_points, double *points) const;
+
+        /// @brief Distance of the end of the chain from the axis of the joint of segment `ith_segment`
+        template <typename Derived>
+        double Radius(int ith_segment, const Eigen::MatrixBase<Derived> &q) const
+        {
+            if (ith_segment >= (int)this->segments.size())
+            {
+                return 0.0;
+            }
+
+            Eigen::Isometry3d frame = Eigen::Isometry3d::Identity();
+            Eigen::Isometry3d joint_frame;
+            for (size_t i = 0; i < this->segments.size(); ++i)
+            {
+                if ((int)i == ith_segment)
+                {
+                    joint_frame = frame;
+                }
+                frame = frame * this->SegmentPose(i, q);
+            }
+
+            // joint axis in the world frame, unit length
+            Eigen::Vector3d joint_axis = joint_frame.linear() * this->segments[ith_segment].axis;
+            Eigen::Vector3d diff = frame.translation() - joint_frame.translation();
+
+            // Project the end effector onto the plane defined by the joint axis
+            return (diff - diff.dot(joint_axis) * joint_axis).norm();
+        }
+
+        /// @brief Per joint, an upper bound over all configurations of how far any point of the chain moves per unit of joint motion
+        /// Revolute joints get the summed length of all downstream links, prismatic joints adding their largest travel in `max_travel`;
+        /// prismatic joints themselves get 1
+        Eigen::VectorXd RadiusBounds(const Eigen::VectorXd &max_travel) const;
+
+        /// @brief `Radius(i, q)` of every i < radii.size() from one walk of the chain
+        template <typename Derived, typename RadiiDerived>
+        void Radii(const Eigen::MatrixBase<Derived> &q, Eigen::MatrixBase<RadiiDerived> &radii) const
+        {
+            constexpr int Size = RadiiDerived::SizeAtCompileTime;
+            const int num_radii = radii.size();
+            const int num_segments = this->segments.size();
+
+            // joint origins and world axes on the way out, the end effector at the end
+            Eigen::Matrix<double, 3, Size> origins(3, num_radii);
+            Eigen::Matrix<double, 3, Size> axes(3, num_radii);
+
+            Eigen::Isometry3d frame = Eigen::Isometry3d::Identity();
+            for (int i = 0; i < num_segments; ++i)
+            {
+                if (i < num_radii)
+                {
+                    origins.col(i) = frame.translation();
+                    axes.col(i) = frame.linear() * this->segments[i].axis;
+                }
+                frame = frame * this->SegmentPose(i, q);
+            }
+
+            for (int i = 0; i < num_radii; ++i)
+            {
+                if (i >= num_segments)
+                {
+                    radii(i) = 0.0;
+                    continue;
+                }
+                Eigen::Vector3d diff = frame.translation() - origins.col(i);
+                radii(i) = (diff - diff.dot(axes.col(i)) * axes.col(i)).norm();
+            }
+        }
+
+    private:
+        std::vector<CompiledSegment> segments;
+        int num_joints = 0;
+    };
+}
+
+#endif
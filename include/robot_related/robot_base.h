@@ -14,6 +14,7 @@
 #include <Eigen/Dense>
 
 #include "bur_related/bur_funcs.h"
+#include "robot_related/compiled_chain.h"
 
 #ifndef ROBOT_BASE_H
 #define ROBOT_BASE_H
@@ -33,7 +34,8 @@ namespace Burs
         std::map<int, std::string> segmentIdToFile;
         std::vector<std::vector<double>> minMaxBounds;
 
-        // std::shared_ptr<KDL::ChainFkSolverPos_recursive> fk_solver;
+        /// @brief `kdl_chain` flattened once at construction, evaluates the forward kinematics
+        CompiledChain compiled_chain;
 
         RobotBase(std::string urdf_filename);
 
@@ -67,20 +69,103 @@ namespace Burs
         std::tuple<std::vector<Eigen::Matrix3d>, std::vector<Eigen::Vector3d>>
         ForwardQ(const Eigen::VectorXd &q_in);
 
-        Eigen::Vector3d
-        GetForwardPoint(const int &ith_distal_point, const Eigen::VectorXd &q_in);
+        /// @brief Pose of every segment from one walk of the chain, written into the caller's buffers
+        void
+        ForwardQ(const Eigen::VectorXd &q_in, std::vector<Eigen::Matrix3d> &rotations, std::vector<Eigen::Vector3d> &positions);
 
-        ForwardKinematics GetForwardPointFunc();
+        // configurations are taken by `Ref` so that fixed-size vectors of the DOF-specialised planners are not copied
+        Eigen::Vector3d
+        GetForwardPoint(const int &ith_distal_point, const Eigen::Ref<const Eigen::VectorXd> &q_in);
+
+        template <int DOF = Eigen::Dynamic>
+        ForwardKinematicsT<DOF> GetForwardPointFunc()
+        {
+            ForwardKinematicsT<DOF> fpf = [this](const int &ith_distal_point, const ConfigT<DOF> &configuration) -> Vector3d
+            {
+                return this->GetForwardPoint(ith_distal_point, configuration);
+            };
+            return fpf;
+        }
+
+        /// @brief Distal points 0..points.cols()-1 from one walk of the chain
+        template <typename PointsDerived>
+        void
+        GetForwardPoints(const Eigen::Ref<const Eigen::VectorXd> &q_in, Eigen::MatrixBase<PointsDerived> &points)
+        {
+            assert(q_in.size() == this->compiled_chain.GetNrOfJoints());
+
+            if (points.cols() > this->compiled_chain.GetNrOfSegments() + 1)
+            {
+                throw std::runtime_error("Forward kinematics solver failed at segment " + std::to_string(points.cols() - 1));
+            }
+
+            this->compiled_chain.ForwardPoints(q_in, points);
+        }
+
+        template <int DOF = Eigen::Dynamic>
+        ForwardKinematicsAllT<DOF> GetForwardPointsFunc()
+        {
+            ForwardKinematicsAllT<DOF> fpf = [this](const ConfigT<DOF> &configuration, Matrix<double, 3, DOF> &points)
+            {
+                this->GetForwardPoints(configuration, points);
+            };
+            return fpf;
+        }
+
+        /// @brief `GetForwardPoints` of every column of `configurations` in one vectorised pass
+        /// @param points sized (3 * num_points, configurations.cols()) by the caller, rows 3i..3i+2 hold point i
+        void
+        GetForwardPointsBatch(const Eigen::Ref<const Eigen::MatrixXd> &configurations, Eigen::MatrixXd &points);
+
+        template <int DOF = Eigen::Dynamic>
+        ForwardKinematicsBatchT<DOF> GetForwardPointsBatchFunc()
+        {
+            ForwardKinematicsBatchT<DOF> fpf = [this](const Matrix<double, DOF, Dynamic> &configurations, MatrixXd &points)
+            {
+                this->GetForwardPointsBatch(configurations, points);
+            };
+            return fpf;
+        }
 
         // pqp_handler.kdl_chain.getNrOfSegments() gets the end-effector
         double
-        GetRadius(const int &ith_distal_point, const Eigen::VectorXd &q_in);
-
-        RadiusFunc
-        GetRadiusFunc();
+        GetRadius(const int &ith_distal_point, const Eigen::Ref<const Eigen::VectorXd> &q_in);
+
+        /// @brief `GetRadius(i, q_in)` of every i < radii.size() from one walk of the chain
+        template <typename RadiiDerived>
+        void
+        GetRadii(const Eigen::Ref<const Eigen::VectorXd> &q_in, Eigen::MatrixBase<RadiiDerived> &radii)
+        {
+            assert(q_in.size() == this->compiled_chain.GetNrOfJoints());
+
+            this->compiled_chain.Radii(q_in, radii);
+        }
+
+        /// @brief Configuration-independent upper bounds of the protective radius of every joint, from the link lengths and joint limits
+        Eigen::VectorXd
+        GetRadiusBounds();
+
+        template <int DOF = Eigen::Dynamic>
+        RadiusFuncT<DOF>
+        GetRadiusFunc()
+        {
+            RadiusFuncT<DOF> rf = [this](const int &ith_distal_point, const ConfigT<DOF> &configuration) -> double
+            {
+                return this->GetRadius(ith_distal_point, configuration);
+            };
+            return rf;
+        }
 
         std::vector<std::vector<double>>
         GetMinMaxBounds();
+
+        /// @brief For each joint whether it is continuous, i.e. its value wraps around at 2 pi
+        std::vector<bool>
+        GetContinuousJoints();
+
+        /// @brief Approximate workspace motion per unit of each joint at `q_in`: protective radius for revolute joints, 1 for prismatic
+        std::vector<double>
+        GetJointWeights(const Eigen::VectorXd &q_in);
     };
 }
 #endif
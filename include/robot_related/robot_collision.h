@@ -33,6 +33,9 @@ namespace Burs
         ForwardRt GetSelectedForwardRtFunc();
 
         std::vector<std::shared_ptr<RtModels::RtModel>> GetModels();
+
+        /// @brief Chain segment of every model returned by `GetModels`
+        std::vector<int> GetModelSegmentIds();
     };
 
     /* Accept the three functions from outside. Link the URDF to the bur-planning algorithm. */
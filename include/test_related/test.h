@@ -14,6 +14,8 @@
 #include <fstream>
 // #include <yaml-cpp/yaml.h>
 #include <cstdlib>
+#include <cstdio>
+#include <thread>
 
 #include "test_related/test_urdf.h"
 
@@ -110,6 +112,8 @@ namespace test
         std::ofstream test_file(test_file_name);
         // for (int i = 0; i <)
         //     urdf_planner.mCollisionEnv->SetPoses(q_waypoint);
+        // the planner poses the robot in its own buffers, the environment has to be posed explicitly
+        urdf_planner.mCollisionEnv->SetPoses(path.back());
         std::cout << "Closest distance from robot to obstacles: " << urdf_planner.mCollisionEnv->GetClosestDistance() << std::endl;
         // urdf_planner.mCollisionEnv->myURDFRobot->
         if (test_file.is_open())
@@ -135,6 +139,144 @@ namespace test
         // auto opt_path = urdf_planner.PlanPath();
     }
 
+    /// @brief Whether node `i` of `a` and node `j` of `b` have the same configurations all the way up to their roots
+    bool same_branch(const BurTree &a, int i, const BurTree &b, int j)
+    {
+        for (; i != -1 && j != -1; i = a.GetParentIdx(i), j = b.GetParentIdx(j))
+        {
+            if (a.GetQ(i) != b.GetQ(j))
+            {
+                return false;
+            }
+        }
+        return i == j;
+    }
+
+    /// @brief Save and load a tree, reroot it the way a warm-started query does and save and load it again
+    bool test_tree_snapshot()
+    {
+        std::cout << "BEGIN TEST TREE SNAPSHOT" << std::endl;
+        const int q_dim = 3;
+        std::string snapshot_path = "tree_snapshot_test.burt";
+
+        BurTree tree(Eigen::VectorXd::Zero(q_dim), q_dim);
+        for (int i = 1; i < 100; ++i)
+        {
+            tree.AddNode(std::rand() % i, Eigen::VectorXd::Random(q_dim));
+        }
+        tree.SetDistance(42, 0.5);
+
+        tree.Save(snapshot_path);
+        std::shared_ptr<BurTree> loaded = BurTree::Load(snapshot_path, q_dim);
+
+        // like `RbtConnect` attaching a new start below node 57
+        loaded->AddNode(57, Eigen::VectorXd::Constant(q_dim, 2.0));
+        loaded->Reroot(loaded->GetNumberOfNodes() - 1);
+
+        loaded->Save(snapshot_path);
+        std::shared_ptr<BurTree> reloaded = BurTree::Load(snapshot_path, q_dim);
+
+        bool ok = reloaded->GetNumberOfNodes() == loaded->GetNumberOfNodes() &&
+                  reloaded->GetQ(reloaded->GetRootIdx()) == Eigen::VectorXd::Constant(q_dim, 2.0);
+        // breadth-first saving renumbers the nodes, every node has to keep its branch and its cached distance
+        for (int j = 0; j < reloaded->GetNumberOfNodes() && ok; ++j)
+        {
+            int i = 0;
+            while (i < loaded->GetNumberOfNodes() && !same_branch(*loaded, i, *reloaded, j))
+            {
+                ++i;
+            }
+            ok = i < loaded->GetNumberOfNodes() && loaded->GetDistance(i) == reloaded->GetDistance(j);
+        }
+        std::remove(snapshot_path.c_str());
+
+        std::cout << (ok ? "OK" : "FAILED") << ": snapshot round trip of a rerooted tree" << std::endl;
+        std::cout << "END TEST TREE SNAPSHOT" << std::endl;
+        return ok;
+    }
+
+    /// @brief Query one shared environment from several threads, each with its own poses, against serial queries
+    bool test_concurrent_queries()
+    {
+        std::cout << "BEGIN TEST CONCURRENT QUERIES" << std::endl;
+        std::string cube_path = "concurrent_query_cube.obj";
+        {
+            std::ofstream cube(cube_path);
+            cube << "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv 0 0 1\nv 1 0 1\nv 1 1 1\nv 0 1 1\n"
+                 << "f 1 3 2\nf 1 4 3\nf 5 6 7\nf 5 7 8\nf 1 2 6\nf 1 6 5\n"
+                 << "f 2 3 7\nf 2 7 6\nf 3 4 8\nf 3 8 7\nf 4 1 5\nf 4 5 8\n";
+        }
+
+        const int num_links = 4;
+        BaseEnv env;
+        for (int i = 0; i < num_links; ++i)
+        {
+            env.AddRobotModel(std::make_shared<RtModels::RtModel>(cube_path), i);
+        }
+        // link i turns about z by q_i and slides along y by q_i
+        ForwardRt forward_rt = [](const VectorXd &q) -> std::tuple<std::vector<Matrix3d>, std::vector<Vector3d>>
+        {
+            std::vector<Matrix3d> rotations;
+            std::vector<Vector3d> translations;
+            for (int i = 0; i < q.size(); ++i)
+            {
+                rotations.push_back(eulerToRotationMatrix(0, 0, q[i]));
+                translations.push_back(Vector3d(1.5 * i, q[i], 0));
+            }
+            return std::make_tuple(rotations, translations);
+        };
+        env.AddForwardRt(forward_rt);
+        for (int k = 0; k < 3; ++k)
+        {
+            env.AddObstacle(cube_path, eulerToRotationMatrix(k, 0.5 * k, 0), Vector3d(2.0 * k, 3.0, 0.5 * k));
+        }
+
+        const int num_queries = 64;
+        std::vector<VectorXd> configs;
+        std::vector<double> expected;
+        std::vector<RtModels::RtPose> poses;
+        for (int j = 0; j < num_queries; ++j)
+        {
+            configs.push_back(VectorXd::Random(num_links) * 3);
+            env.ComputePoses(configs.back(), poses);
+            expected.push_back(env.GetClosestDistance(poses));
+        }
+
+        // the threads start at different configurations and go over all of them, so they query the same models at once
+        const int num_threads = 8;
+        std::vector<int> mismatches(num_threads, 0);
+        std::vector<std::thread> threads;
+        auto query_all = [&](int t)
+        {
+            std::vector<RtModels::RtPose> thread_poses;
+            for (int j = 0; j < 10 * num_queries; ++j)
+            {
+                int query = (j + t) % num_queries;
+                env.ComputePoses(configs[query], thread_poses);
+                double distance = env.GetClosestDistance(thread_poses);
+                // PQP resolves distances to 1e-3, another warm start may land elsewhere within that
+                if (std::abs(distance - expected[query]) > 2e-3 * (1 + expected[query]))
+                {
+                    mismatches[t]++;
+                }
+            }
+        };
+        for (int t = 0; t < num_threads; ++t)
+        {
+            threads.emplace_back(query_all, t);
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        std::remove(cube_path.c_str());
+
+        bool ok = std::count(mismatches.begin(), mismatches.end(), 0) == num_threads;
+        std::cout << (ok ? "OK" : "FAILED") << ": " << num_threads << " threads querying one environment" << std::endl;
+        std::cout << "END TEST CONCURRENT QUERIES" << std::endl;
+        return ok;
+    }
+
     // void testFunctions(int argc, char *argv[])
     // {
     //     if (argc < 3)
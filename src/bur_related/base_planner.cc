@@ -1,4 +1,5 @@
 #include "bur_related/burs.h"
+#include "robot_related/robot_base.h"
 // #include "bur_related/bur_env.h"
 // #include "bur_related/bur_algorithm.h"
 // #include "bur_related/bur_tree.h"
@@ -8,45 +9,72 @@
 #include <memory>
 #include <iostream>
 #include <fstream>
+#include <omp.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
 
 namespace Burs
 {
     using namespace Eigen;
 
-    BasePlanner::BasePlanner(int q_dim, ForwardKinematics f, int max_iters, double d_crit, double delta_q, double epsilon_q, MatrixXd bounds, RadiusFunc radius_func, int num_spikes)
-        : q_dim(q_dim), forwardKinematics(f), max_iters(max_iters), d_crit(d_crit), delta_q(delta_q), epsilon_q(epsilon_q), bounds(bounds), radius_func(radius_func), num_spikes(num_spikes)
+    /// @brief Spikes of a bur that are stepped together, one SIMD register of configurations
+    static constexpr int kBurBlock = 4;
+
+    template <int DOF, typename Robot>
+    BasePlannerT<DOF, Robot>::BasePlannerT(int q_dim, std::shared_ptr<Robot> robot, int max_iters, double d_crit, double delta_q, double epsilon_q, MatrixXd bounds, int num_spikes)
+        : q_dim(q_dim), robot(robot), max_iters(max_iters), d_crit(d_crit), delta_q(delta_q), epsilon_q(epsilon_q), bounds(bounds), num_spikes(num_spikes)
     {
+        if (DOF != Dynamic && q_dim != DOF)
+        {
+            throw std::runtime_error("Planner for " + std::to_string(DOF) + " joints cannot plan for " + std::to_string(q_dim) + " joints.");
+        }
     }
 
-    BasePlanner::~BasePlanner()
+    template <int DOF, typename Robot>
+    BasePlannerT<DOF, Robot>::~BasePlannerT()
     {
     }
 
-    Vector3d BasePlanner::ForwardEuclideanJoint(const int &ith_distal_point, const VectorXd &configuration) const
+    template <int DOF, typename Robot>
+    Vector3d BasePlannerT<DOF, Robot>::ForwardEuclideanJoint(const int &ith_distal_point, const Config &configuration) const
     {
-        return this->forwardKinematics(ith_distal_point, configuration);
+        return this->robot->GetForwardPoint(ith_distal_point, configuration);
     }
 
-    double BasePlanner::RhoR(const VectorXd &q1, const VectorXd &q2) const
+    template <int DOF, typename Robot>
+    double BasePlannerT<DOF, Robot>::RhoR(const Config &q1, const Config &q2) const
     {
-        double max_distance = 0.0;
-        auto fk = this->forwardKinematics;
+        Points points_1(3, this->q_dim);
+        Points points_2(3, this->q_dim);
 
-        for (int i = 0; i < this->q_dim; i++)
-        {
-            // std::cout << "i: " << i << " q1 " << q1.transpose() << " q2: " << q2.transpose() << std::endl;
-            // std::cout << "fk(i, q1): " << fk(i, q1) << std::endl;
-            double tmp = (fk(i, q1) - fk(i, q2)).norm();
-            // std::cout << " i: " << i << " q1: " << q1.transpose() << " => " << fk(i, q1).transpose() << " q2: " << q2.transpose() << " => " << fk(i, q2).transpose() << std::endl;
-            if (tmp > max_distance)
-            {
-                max_distance = tmp;
-            }
-        }
-        return max_distance;
+        // all distal points of a configuration from one kinematics pass
+        this->robot->GetForwardPoints(q1, points_1);
+        this->robot->GetForwardPoints(q2, points_2);
+
+        return (points_1 - points_2).colwise().norm().maxCoeff();
     }
 
-    double BasePlanner::GetPhiFunction(const double &d_closest, const VectorXd &q, const VectorXd &q_e, const double &t) const
+    template <int DOF, typename Robot>
+    double BasePlannerT<DOF, Robot>::RhoR(BurContext &context, const Config &q) const
+    {
+        this->robot->GetForwardPoints(q, context.points);
+
+        return (context.center_points - context.points).colwise().norm().maxCoeff();
+    }
+
+    template <int DOF, typename Robot>
+    void BasePlannerT<DOF, Robot>::InitBurContext(BurContext &context, const Config &q_near) const
+    {
+        context.center = q_near;
+        context.center_points.resize(3, this->q_dim);
+        context.points.resize(3, this->q_dim);
+        this->robot->GetForwardPoints(q_near, context.center_points);
+    }
+
+    template <int DOF, typename Robot>
+    double BasePlannerT<DOF, Robot>::GetPhiFunction(const double &d_closest, const Config &q, const Config &q_e, const double &t) const
     {
         return d_closest - RhoR(q, q + t * (q_e - q));
     }
@@ -60,23 +88,23 @@ namespace Burs
     //     return phi_func;
     // }
 
-    double BasePlanner::GetDeltaTk(double phi_tk, double tk, const VectorXd &q_e, const VectorXd &q_k) const
+    template <int DOF, typename Robot>
+    double BasePlannerT<DOF, Robot>::GetDeltaTk(double phi_tk, double tk, const Config &q_e, const Config &q_k) const
     {
         double numerator_sum = 0;
 
-        VectorXd r_vec(this->q_dim);
+        Config r_vec(this->q_dim);
 
-        for (int i = 0; i < this->q_dim; i++)
-        {
-            r_vec[i] = this->radius_func(i, q_k);
-        }
+        // every radius shares the end-effector pose, one kinematics pass gives them all
+        this->robot->GetRadii(q_k, r_vec);
 
         return phi_tk * (1 - tk) / (r_vec.transpose() * (q_e - q_k).cwiseAbs());
     }
 
-    MatrixXd BasePlanner::GetRandomQ(const int &num_spikes) const
+    template <int DOF, typename Robot>
+    typename BasePlannerT<DOF, Robot>::Configs BasePlannerT<DOF, Robot>::GetRandomQ(const int &num_spikes) const
     {
-        MatrixXd m = MatrixXd::Random(this->q_dim, num_spikes);
+        Configs m = Configs::Random(this->q_dim, num_spikes);
         m.array() += 1.0; // Using .array() allows element-wise addition
         m.array() /= 2.0;
 
@@ -89,12 +117,25 @@ namespace Burs
         return m;
     }
 
-    VectorXd BasePlanner::GetEndpoint(const VectorXd &q_ei, const VectorXd &q_near, double factor) const
+    template <int DOF, typename Robot>
+    typename BasePlannerT<DOF, Robot>::Config BasePlannerT<DOF, Robot>::GetEndpoint(const Config &q_ei, const Config &q_near, double factor) const
+    {
+        return q_near + factor * this->GetDelta(q_near, q_ei).normalized();
+    }
+
+    template <int DOF, typename Robot>
+    typename BasePlannerT<DOF, Robot>::Config BasePlannerT<DOF, Robot>::GetDelta(const Config &q_from, const Config &q_to) const
     {
-        return q_near + factor * (q_ei - q_near).normalized();
+        Config delta = q_to - q_from;
+        for (int k : this->continuous_joints)
+        {
+            delta[k] -= 2.0 * M_PI * std::round(delta[k] / (2.0 * M_PI));
+        }
+        return delta;
     }
 
-    void BasePlanner::GetEndpoints(MatrixXd &Qe, const VectorXd &q_near, double factor) const
+    template <int DOF, typename Robot>
+    void BasePlannerT<DOF, Robot>::GetEndpoints(Configs &Qe, const Config &q_near, double factor) const
     {
         // MatrixXd normalized_Qe = Qe; // Create a copy of Qe to store the normalized results
         for (int j = 0; j < Qe.cols(); ++j)
@@ -103,34 +144,86 @@ namespace Burs
         }
     }
 
-    std::optional<std::vector<Eigen::VectorXd>> BasePlanner::RbtConnect(const VectorXd &q_start, const VectorXd &q_goal)
+    template <int DOF, typename Robot>
+    std::optional<std::vector<Eigen::VectorXd>> BasePlannerT<DOF, Robot>::RbtConnect(const Config &q_start, const Config &q_goal)
+    {
+        std::shared_ptr<BurTree> t_start = std::make_shared<BurTree>(q_start, q_start.rows(), this->nn_params);
+        std::shared_ptr<BurTree> t_goal = std::make_shared<BurTree>(q_goal, q_goal.rows(), this->nn_params);
+        return this->GrowTrees(t_start, t_goal);
+    }
+
+    template <int DOF, typename Robot>
+    std::optional<std::vector<Eigen::VectorXd>> BasePlannerT<DOF, Robot>::RbtConnect(const Config &q_start, const Config &q_goal, std::shared_ptr<BurTree> t_start, std::shared_ptr<BurTree> t_goal)
+    {
+        return this->GrowTrees(this->AttachRoot(t_start, q_start), this->AttachRoot(t_goal, q_goal));
+    }
+
+    template <int DOF, typename Robot>
+    std::shared_ptr<BurTree> BasePlannerT<DOF, Robot>::AttachRoot(std::shared_ptr<BurTree> t, const Config &q)
     {
+        int root = t->GetRootIdx();
+        if (t->GetQ(root) == q)
+        {
+            return t;
+        }
+
+        Config q_root(q);
+        int connected_index;
+        if (this->BurConnect(t, q_root, connected_index) != AlgorithmState::Reached)
+        {
+            std::cout << "query point cannot be connected to the tree, growing a new one" << std::endl;
+            return std::make_shared<BurTree>(q, this->q_dim, this->nn_params);
+        }
+
+        t->AddNode(connected_index, q);
+        t->Reroot(t->GetNumberOfNodes() - 1);
+        return t;
+    }
+
+    template <int DOF, typename Robot>
+    std::optional<std::vector<Eigen::VectorXd>> BasePlannerT<DOF, Robot>::GrowTrees(std::shared_ptr<BurTree> t_start, std::shared_ptr<BurTree> t_goal)
+    {
+        // kept so that the trees can be saved and reused by the next query
+        this->start_tree = t_start;
+        this->goal_tree = t_goal;
+
         // start of actual algorithm
-        std::shared_ptr<BurTree> t_start = std::make_shared<BurTree>(q_start, q_start.rows());
-        std::shared_ptr<BurTree> t_goal = std::make_shared<BurTree>(q_goal, q_goal.rows());
         auto t_a = t_start;
         auto t_b = t_goal;
 
         for (int k = 0; k < this->max_iters; k++)
         {
-            VectorXd q_new(this->q_dim);
-            Eigen::MatrixXd Qe = this->GetRandomQ(num_spikes);
+            Config q_new(this->q_dim);
+            Configs Qe = this->GetRandomQ(num_spikes);
 
             // random growth direction; can be any other among the random vectors from Qe
-            VectorXd q_e_0 = Qe.col(0);
+            Config q_e_0 = Qe.col(0);
             int nearest_index = this->NearestIndex(t_a, q_e_0);
 
-            const VectorXd q_near = t_a->GetQ(nearest_index);
+            const Config q_near = t_a->GetQ(nearest_index);
 
             for (int i = 0; i < num_spikes; i++)
             {
-                VectorXd q_e_i = Qe.col(i);
+                Config q_e_i = Qe.col(i);
                 q_e_i = this->GetEndpoint(q_e_i, q_near, this->delta_q);
                 Qe.col(i).array() = q_e_i;
             }
 
-            double d_closest = this->GetClosestDistance(q_near);
+            // one distance query per node: in per-link mode the clearances also give the closest distance
+            std::optional<Config> clearances;
+            double d_closest;
+            if (this->per_link_clearance && !t_a->GetDistance(nearest_index))
+            {
+                clearances = this->GetPointClearances(q_near);
+                d_closest = clearances->minCoeff();
+                t_a->SetDistance(nearest_index, d_closest);
+            }
+            else
+            {
+                d_closest = this->GetNodeDistance(t_a, nearest_index);
+            }
             std::cout << "d_closest: " << d_closest << std::endl;
+
             if (d_closest < 1e-3)
             {
                 std::cout << "CLOSEST DISTANCE TOO SMALL" << std::endl;
@@ -145,7 +238,8 @@ namespace Burs
                 q_new = this->GetEndpoint(q_e_0, q_near, this->epsilon_q);
                 std::cout << "q_new: " << q_new.transpose() << std::endl;
 
-                if (!this->IsColliding(q_new))
+                // a node closer than 1e-3 would end the search once it is picked as the nearest one
+                if (!this->IsWithinDistance(q_new, 1e-3))
                 {
                     t_a->AddNode(nearest_index, q_new);
                 }
@@ -156,12 +250,16 @@ namespace Burs
             }
             else
             {
-                Bur b = this->GetBur(q_near, Qe, d_closest);
-
-                for (int i = 0; i < Qe.cols(); ++i)
+                if (this->per_link_clearance && !clearances)
                 {
-                    t_a->AddNode(nearest_index, b.endpoints.col(i));
+                    // the node distance was cached
+                    clearances = this->GetPointClearances(q_near);
                 }
+
+                Bur b = this->per_link_clearance ? this->GetBur(q_near, Qe, clearances.value())
+                                                 : this->GetBur(q_near, Qe, d_closest);
+
+                t_a->AddNodes(nearest_index, b.endpoints.data(), b.endpoints.cols());
                 // doesn't matter which column, since they all go in random directions
                 q_new = b.endpoints.col(0);
             }
@@ -169,11 +267,11 @@ namespace Burs
             // if small basic rrt collides, then don't go here `continue`
 
             // if reached, then index is the closest node in `t_b` to `q_new` in `t_a`
-            AlgorithmState status = this->BurConnect(t_b, q_new);
+            int b_closest;
+            AlgorithmState status = this->BurConnect(t_b, q_new, b_closest);
             if (status == AlgorithmState::Reached)
             {
                 int a_closest = t_a->Nearest(q_new.data());
-                int b_closest = t_b->Nearest(q_new.data());
 
                 return this->Path(t_a, a_closest, t_b, b_closest);
             }
@@ -185,43 +283,73 @@ namespace Burs
         return {};
     }
 
-    AlgorithmState BasePlanner::BurConnect(std::shared_ptr<BurTree> t, VectorXd &q)
+    template <int DOF, typename Robot>
+    AlgorithmState BasePlannerT<DOF, Robot>::BurConnect(std::shared_ptr<BurTree> t, Config &q, int &connected_index)
     {
-        int nearest_index = t->Nearest(q.data());
+        // the nearest node can be trapped behind an obstacle, so try the next closest ones as well
+        auto [candidates, candidate_dists] = t->KNearest(q, this->connect_candidates);
 
-        VectorXd q_n = t->GetQ(nearest_index);
-        VectorXd q_0(q_n);
+        for (int candidate : candidates)
+        {
+            if (this->BurConnectFrom(t->GetQ(candidate), q) == AlgorithmState::Reached)
+            {
+                connected_index = candidate;
+                return AlgorithmState::Reached;
+            }
+        }
+        return AlgorithmState::Trapped;
+    }
+
+    template <int DOF, typename Robot>
+    AlgorithmState BasePlannerT<DOF, Robot>::BurConnectFrom(const Config &q_start, Config &q)
+    {
+        Config q_n(q_start);
+        Config q_0(q_n);
+        // the copy of `q` the short way round from `q_start`, all the steps below head for it
+        Config q_target = q_start + this->GetDelta(q_start, q);
 
         double delta_s = 1e14;
         double threshold = 1e-2;
 
         while (delta_s >= this->d_crit)
         {
-            double d_closest = this->GetClosestDistance(q_n);
+            // one distance query per configuration: in per-link mode the clearances also give the closest distance
+            Config clearances;
+            double d_closest;
+            if (this->per_link_clearance)
+            {
+                clearances = this->GetPointClearances(q_n);
+                d_closest = clearances.minCoeff();
+            }
+            else
+            {
+                d_closest = this->GetClosestDistance(q_n);
+            }
             std::cout << "d_closest: " << d_closest << std::endl;
 
             if (d_closest > this->d_crit)
             {
                 // if q_n is within the collision free bur of q, then we finish, game over
-                Bur b = this->GetBur(q_n, q, d_closest);
+                Bur b = this->per_link_clearance ? this->GetBur(q_n, q_target, clearances)
+                                                 : this->GetBur(q_n, q_target, d_closest);
 
-                VectorXd q_t = b.endpoints.col(0);
+                Config q_t = b.endpoints.col(0);
 
                 double delta_s = (q_t - q_n).norm();
 
                 q_n = q_t;
 
-                if (q_n.isApprox(q, threshold))
+                if (q_n.isApprox(q_target, threshold))
                 {
                     return AlgorithmState::Reached;
                 }
             }
             else
             {
-                VectorXd q_t = this->GetEndpoint(q, q_n, this->epsilon_q);
+                Config q_t = this->GetEndpoint(q_target, q_n, this->epsilon_q);
 
-                // if not colliding then proceed
-                if (!this->IsColliding(q_t))
+                // only a comparison is needed here, the next iteration measures the distance at q_t
+                if (!this->IsWithinDistance(q_t, 1e-3))
                 {
                     q_n = q_t;
                 }
@@ -230,7 +358,7 @@ namespace Burs
                     return AlgorithmState::Trapped;
                 }
 
-                if ((q_n - q_0).norm() >= (q - q_0).norm())
+                if ((q_n - q_0).norm() >= (q_target - q_0).norm())
                 {
                     return AlgorithmState::Reached;
                 }
@@ -239,68 +367,262 @@ namespace Burs
         return AlgorithmState::Trapped;
     }
 
-    VectorXd BasePlanner::Nearest(std::shared_ptr<BurTree> t, VectorXd &q)
+    template <int DOF, typename Robot>
+    typename BasePlannerT<DOF, Robot>::Config BasePlannerT<DOF, Robot>::Nearest(std::shared_ptr<BurTree> t, const Config &q)
     {
         return t->GetQ(t->Nearest(q.data()));
     }
 
-    int BasePlanner::NearestIndex(std::shared_ptr<BurTree> t, VectorXd &q)
+    template <int DOF, typename Robot>
+    int BasePlannerT<DOF, Robot>::NearestIndex(std::shared_ptr<BurTree> t, const Config &q)
     {
         return t->Nearest(q.data());
     }
 
-    double BasePlanner::GetClosestDistance(const VectorXd &q)
+    template <int DOF, typename Robot>
+    double BasePlannerT<DOF, Robot>::GetNodeDistance(std::shared_ptr<BurTree> t, int index)
+    {
+        std::optional<double> cached = t->GetDistance(index);
+        if (cached)
+        {
+            return cached.value();
+        }
+
+        double d_closest = this->GetClosestDistance(t->GetQ(index));
+        t->SetDistance(index, d_closest);
+        return d_closest;
+    }
+
+    template <int DOF, typename Robot>
+    std::shared_ptr<BurTree> BasePlannerT<DOF, Robot>::GetStartTree() const
+    {
+        return this->start_tree;
+    }
+
+    template <int DOF, typename Robot>
+    std::shared_ptr<BurTree> BasePlannerT<DOF, Robot>::GetGoalTree() const
+    {
+        return this->goal_tree;
+    }
+
+    template <int DOF, typename Robot>
+    double BasePlannerT<DOF, Robot>::GetClosestDistance(const Config &q)
     {
-        this->bur_env->SetPoses(q);
-        return this->bur_env->GetClosestDistance();
+        this->bur_env->ComputePoses(q, this->robot_poses);
+        return this->bur_env->GetClosestDistance(this->robot_poses, this->distance_cap);
     }
 
-    void BasePlanner::SetBurEnv(std::shared_ptr<BaseEnv> bur_env)
+    template <int DOF, typename Robot>
+    typename BasePlannerT<DOF, Robot>::Config BasePlannerT<DOF, Robot>::GetPointClearances(const Config &q)
+    {
+        this->bur_env->ComputePoses(q, this->robot_poses);
+        return this->bur_env->GetPointClearances(this->robot_poses, this->q_dim, this->distance_cap);
+    }
+
+    template <int DOF, typename Robot>
+    void BasePlannerT<DOF, Robot>::SetBurEnv(std::shared_ptr<BaseEnv> bur_env)
     {
         this->bur_env = bur_env;
     }
 
-    Bur BasePlanner::GetBur(const VectorXd &q_near, const MatrixXd &Q_e, double d_closest)
+    template <int DOF, typename Robot>
+    std::shared_ptr<Robot> BasePlannerT<DOF, Robot>::GetRobot() const
+    {
+        return this->robot;
+    }
+
+    template <int DOF, typename Robot>
+    void BasePlannerT<DOF, Robot>::SetRadiusBounds(std::optional<Config> radius_bounds)
     {
+        this->radius_bounds = radius_bounds;
+    }
+
+    template <int DOF, typename Robot>
+    void BasePlannerT<DOF, Robot>::SetPerLinkClearance(bool per_link_clearance)
+    {
+        this->per_link_clearance = per_link_clearance;
+    }
+
+    template <int DOF, typename Robot>
+    void BasePlannerT<DOF, Robot>::SetMaxBurIters(int max_bur_iters)
+    {
+        this->max_bur_iters = max_bur_iters;
+    }
+
+    template <int DOF, typename Robot>
+    void BasePlannerT<DOF, Robot>::SetDistanceCap(double distance_cap)
+    {
+        this->distance_cap = distance_cap;
+    }
+
+    template <int DOF, typename Robot>
+    void BasePlannerT<DOF, Robot>::SetBurThreads(int bur_threads)
+    {
+        this->bur_threads = bur_threads;
+    }
+
+    template <int DOF, typename Robot>
+    void BasePlannerT<DOF, Robot>::SetNNParams(NNParams nn_params)
+    {
+        this->nn_params = nn_params;
+
+        this->continuous_joints.clear();
+        for (int k = 0; k < std::min<int>(nn_params.continuous_joints.size(), this->q_dim); ++k)
+        {
+            if (nn_params.continuous_joints[k])
+            {
+                this->continuous_joints.push_back(k);
+            }
+        }
+    }
+
+    template <int DOF, typename Robot>
+    void BasePlannerT<DOF, Robot>::SetConnectCandidates(int connect_candidates)
+    {
+        this->connect_candidates = connect_candidates;
+    }
+
+    template <int DOF, typename Robot>
+    typename BasePlannerT<DOF, Robot>::Bur BasePlannerT<DOF, Robot>::GetBur(const Config &q_near, const Configs &Q_e, double d_closest)
+    {
+        // the global closest distance bounds every distal point alike
+        return this->GetBur(q_near, Q_e, Config(Config::Constant(this->q_dim, d_closest)));
+    }
+
+    template <int DOF, typename Robot>
+    typename BasePlannerT<DOF, Robot>::Bur BasePlannerT<DOF, Robot>::GetBur(const Config &q_near, const Configs &Q_e, const Config &point_clearances)
+    {
+        double d_closest = point_clearances.minCoeff();
         double d_small = 0.1 * d_closest;
-        MatrixXd endpoints = MatrixXd::Zero(this->q_dim, Q_e.cols());
+        const int num_spikes = Q_e.cols();
+        Configs endpoints = Configs::Zero(this->q_dim, num_spikes);
 
-        for (int i = 0; i < Q_e.cols(); ++i)
+        if (this->radius_bounds)
         {
-            double tk = 0;
+            // with constant radii the first Newton step is already the whole step
+            for (int i = 0; i < num_spikes; ++i)
+            {
+                double tk = d_closest / this->radius_bounds->dot((Q_e.col(i) - q_near).cwiseAbs());
+                endpoints.col(i) = tk >= 1 ? Config(Q_e.col(i)) : Config(q_near + tk * (Q_e.col(i) - q_near));
+            }
+            return Bur(q_near, endpoints);
+        }
 
-            // always start out from the center
-            VectorXd q_k(q_near);
-            double phi_result = d_closest;
+        // the centre is the same for every spike
+        BurContext context;
+        this->InitBurContext(context, q_near);
 
-            const VectorXd q_e = Q_e.col(i);
+        // spikes are independent and write disjoint columns, every thread works on its own copy of the context
+        int num_threads = this->bur_threads > 0 ? this->bur_threads : omp_get_max_threads();
+        const int num_blocks = (num_spikes + kBurBlock - 1) / kBurBlock;
+        // an exception must not leave the parallel region, the first one is rethrown after it
+        std::exception_ptr error;
+        std::atomic<bool> failed(false);
 
-            while (phi_result > d_small)
+#pragma omp parallel for firstprivate(context) schedule(dynamic) num_threads(num_threads) if (num_blocks > 1)
+        for (int block = 0; block < num_blocks; ++block)
+        {
+            if (failed)
+            {
+                continue;
+            }
+            try
+            {
+                // the spikes of a block step in lock-step, so that their kinematics is one batch call
+                const int first = block * kBurBlock;
+                const int width = std::min(kBurBlock, num_spikes - first);
+
+                Array<double, 1, kBurBlock> tk = Array<double, 1, kBurBlock>::Zero();
+                Array<double, 1, kBurBlock> phi = Array<double, 1, kBurBlock>::Zero();
+                Array<double, 1, kBurBlock> denominator = Array<double, 1, kBurBlock>::Ones();
+                // lanes past the last spike stay masked out
+                Array<bool, 1, kBurBlock> active = Array<bool, 1, kBurBlock>::Constant(false);
+                active.head(width).setConstant(true);
+
+                // always start out from the center
+                context.batch_q.resize(this->q_dim, width);
+                context.batch_q.colwise() = q_near;
+                context.batch_points.resize(3 * this->q_dim, width);
+                context.batch_distances.resize(this->q_dim, width);
+
+                Config q_k(this->q_dim);
+                Config r_vec(this->q_dim);
+
+                // every iterate is collision free, a spike cut off by the cap just stays shorter
+                for (int iter = 0; iter < this->max_bur_iters && active.any(); ++iter)
+                {
+                    // a finished spike keeps its lane, a SIMD batch costs the same for one to four configurations
+                    this->robot->GetForwardPointsBatch(context.batch_q, context.batch_points);
+
+                    // how far every distal point of every lane moved from the centre, phi of all lanes at once
+                    context.batch_points.colwise() -= Map<const VectorXd>(context.center_points.data(), 3 * this->q_dim);
+                    Map<Matrix<double, 1, Dynamic>>(context.batch_distances.data(), this->q_dim * width) =
+                        Map<const Matrix<double, 3, Dynamic>>(context.batch_points.data(), 3, this->q_dim * width).colwise().norm();
+                    phi.head(width) = -(context.batch_distances.colwise() - point_clearances).colwise().maxCoeff().array();
+
+                    // the radii need the whole chain of a configuration, one lane at a time
+                    for (int j = 0; j < width; ++j)
+                    {
+                        if (active[j])
+                        {
+                            q_k = context.batch_q.col(j);
+                            this->robot->GetRadii(q_k, r_vec);
+                            denominator[j] = r_vec.dot((Q_e.col(first + j) - q_k).cwiseAbs());
+                        }
+                    }
+
+                    tk = active.select(tk + phi * (1 - tk) / denominator, tk);
+                    Array<bool, 1, kBurBlock> reached = active && (tk > 1);
+
+                    for (int j = 0; j < width; ++j)
+                    {
+                        if (reached[j])
+                        {
+                            context.batch_q.col(j) = Q_e.col(first + j);
+                        }
+                        else if (active[j])
+                        {
+                            context.batch_q.col(j) = q_near + tk[j] * (Q_e.col(first + j) - q_near);
+                        }
+                    }
+                    active = active && !reached && (phi > d_small);
+                }
+                endpoints.middleCols(first, width) = context.batch_q;
+            }
+            catch (...)
             {
-                // CHECK: this is indeed PI away from q_near
-                phi_result = d_closest - this->RhoR(q_near, q_k);
-                double delta_tk = this->GetDeltaTk(phi_result, tk, q_e, q_k);
-                tk = tk + delta_tk;
-                if (tk > 1)
+#pragma omp critical
+                if (!error)
                 {
-                    q_k = q_e;
-                    break;
+                    error = std::current_exception();
                 }
-                q_k = q_near + tk * (q_e - q_near);
+                failed = true;
             }
-            endpoints.col(i).array() = q_k;
+        }
+        if (error)
+        {
+            std::rethrow_exception(error);
         }
         Bur myBur(q_near, endpoints);
         return myBur;
     }
 
-    bool BasePlanner::IsColliding(const VectorXd &q)
+    template <int DOF, typename Robot>
+    bool BasePlannerT<DOF, Robot>::IsColliding(const Config &q)
+    {
+        this->bur_env->ComputePoses(q, this->robot_poses);
+        return this->bur_env->IsColliding(this->robot_poses);
+    }
+
+    template <int DOF, typename Robot>
+    bool BasePlannerT<DOF, Robot>::IsWithinDistance(const Config &q, double threshold)
     {
-        this->bur_env->SetPoses(q);
-        return this->bur_env->IsColliding();
+        this->bur_env->ComputePoses(q, this->robot_poses);
+        return this->bur_env->IsWithinDistance(this->robot_poses, threshold);
     }
 
-    std::vector<Eigen::VectorXd> BasePlanner::Path(std::shared_ptr<BurTree> t_a, int a_closest, std::shared_ptr<BurTree> t_b, int b_closest)
+    template <int DOF, typename Robot>
+    std::vector<Eigen::VectorXd> BasePlannerT<DOF, Robot>::Path(std::shared_ptr<BurTree> t_a, int a_closest, std::shared_ptr<BurTree> t_b, int b_closest)
     {
         std::cout << "PATH: " << std::endl;
         std::cout << "A closest: " << t_a->GetQ(a_closest).transpose() << std::endl;
@@ -319,7 +641,7 @@ namespace Burs
         do
         {
             res_b.push_back(node_id_b);
-            node_id_b = t_a->GetParentIdx(node_id_b);
+            node_id_b = t_b->GetParentIdx(node_id_b);
         } while (node_id_b != -1);
 
         std::vector<Eigen::VectorXd> final_path(res_a.size() + res_b.size());
@@ -341,7 +663,23 @@ namespace Burs
             ++k;
         }
 
+        // a connection reaches the copy of a node the short way round, continuous joints continue from their previous value
+        for (int i = 1; i < final_path.size(); ++i)
+        {
+            for (int j : this->continuous_joints)
+            {
+                final_path[i][j] -= 2.0 * M_PI * std::round((final_path[i][j] - final_path[i - 1][j]) / (2.0 * M_PI));
+            }
+        }
+
         std::cout << "END PATH" << std::endl;
         return final_path;
     }
+
+    template class BasePlannerT<Dynamic>;
+    template class BasePlannerT<7>;
+    template class BasePlannerT<9>;
+    template class BasePlannerT<Dynamic, RobotBase>;
+    template class BasePlannerT<7, RobotBase>;
+    template class BasePlannerT<9, RobotBase>;
 }
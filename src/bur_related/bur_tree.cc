@@ -1,58 +1,271 @@
 #include "bur_related/bur_tree.h"
 #include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
 
 namespace Burs
 {
     using namespace Eigen;
 
-    BurTree::BurTree(VectorXd q_location, int q_dim) : mQDim(q_dim)
+    /// @brief Header of a tree snapshot, followed by the row-major configurations, the distances if flagged and the int32 parents
+    struct SnapshotHeader
+    {
+        char magic[4];
+        uint32_t version;
+        int32_t q_dim;
+        uint32_t flags;
+        int64_t num_nodes;
+    };
+
+    static constexpr char kSnapshotMagic[4] = {'B', 'U', 'R', 'T'};
+    static constexpr uint32_t kSnapshotVersion = 1;
+    static constexpr uint32_t kSnapshotHasDistances = 1;
+    static_assert(sizeof(int) == sizeof(int32_t), "parents are stored as int32");
+
+    BurTree::BurTree(VectorXd q_location, int q_dim, NNParams nn_params) : mQDim(q_dim), mNNParams(nn_params), mMetric(q_dim, nn_params.joint_weights, nn_params.continuous_joints)
     {
         this->AddNode(-1, q_location);
     }
 
-    void BurTree::AddNode(int p, VectorXd q_location)
+    BurTree::BurTree(int q_dim, NNParams nn_params, std::vector<double> configs, std::vector<int> parents, std::vector<double> distances)
+        : mQDim(q_dim), mConfigs(std::move(configs)), mParents(std::move(parents)), mDistances(std::move(distances)),
+          mNNParams(nn_params), mMetric(q_dim, nn_params.joint_weights, nn_params.continuous_joints)
+    {
+        this->RefreshIndex();
+    }
+
+    void BurTree::AddNode(int p, const Ref<const VectorXd> &q_location)
+    {
+        this->AppendNodes(p, q_location.data(), 1);
+    }
+
+    void BurTree::AddNodes(int p, const MatrixXd &q_locations)
+    {
+        // column-major (q_dim, n) has the same layout as n row-major rows
+        this->AppendNodes(p, q_locations.data(), q_locations.cols());
+    }
+
+    void BurTree::AddNodes(int p, const double *q_locations, int num_new)
     {
-        this->mNodes.emplace_back(p, q_location);
+        this->AppendNodes(p, q_locations, num_new);
+    }
 
-        // have to build index to register the new node
-        this->BuildIndex();
+    int BurTree::Nearest(const double *new_point)
+    {
+        return this->mIndex->Nearest(new_point);
     }
 
-    int BurTree::Nearest(double *new_point)
+    VectorXi BurTree::NearestBatch(const MatrixXd &queries)
     {
-        flann::Matrix<double> query(new_point, 1, this->mQDim); // Single row matrix for the new point
-        flann::Matrix<int> indices(new int[1], 1, 1);           // Single row matrix for the index
-        flann::Matrix<double> dists(new double[1], 1, 1);       // Single row matrix for the distance
+        VectorXi closest(queries.cols());
+        // column-major (q_dim, n) has the same layout as n row-major queries
+        this->mIndex->NearestBatch(queries.data(), queries.cols(), closest.data());
+        return closest;
+    }
 
-        // Search for the closest point. We're only interested in the Nearest one.
-        this->mIndex.get()->knnSearch(query, indices, dists, 1, flann::SearchParams(128));
+    std::tuple<std::vector<int>, std::vector<double>> BurTree::KNearest(const Ref<const VectorXd> &q, int k)
+    {
+        std::vector<int> indices;
+        std::vector<double> dists;
+        this->mIndex->KNearest(q.data(), k, indices, dists);
+        return std::make_tuple(indices, dists);
+    }
 
-        int closestIndex = indices[0][0];
+    std::tuple<std::vector<int>, std::vector<double>> BurTree::RadiusSearch(const Ref<const VectorXd> &q, double r)
+    {
+        std::vector<int> indices;
+        std::vector<double> dists;
+        this->mIndex->RadiusSearch(q.data(), r, indices, dists);
+        return std::make_tuple(indices, dists);
+    }
 
-        delete[] indices.ptr();
-        delete[] dists.ptr();
+    Map<const VectorXd> BurTree::GetQ(int index) const
+    {
+        return Map<const VectorXd>(this->mConfigs.data() + index * this->mQDim, this->mQDim);
+    }
 
-        return closestIndex; // Return the index of the Nearest node
+    int BurTree::GetParentIdx(int index) const
+    {
+        return this->mParents[index];
     }
 
-    VectorXd BurTree::GetQ(int index)
+    int BurTree::GetRootIdx() const
     {
-        return this->mNodes[index].q;
+        return std::find(this->mParents.begin(), this->mParents.end(), -1) - this->mParents.begin();
     }
 
-    int BurTree::GetParentIdx(int index)
+    void BurTree::Reroot(int new_root)
     {
-        return this->mNodes[index].parent_idx;
+        int previous = -1;
+        for (int node = new_root; node != -1;)
+        {
+            int parent = this->mParents[node];
+            this->mParents[node] = previous;
+            previous = node;
+            node = parent;
+        }
     }
 
-    int BurTree::GetNumberOfNodes()
+    int BurTree::GetNumberOfNodes() const
     {
-        return this->mNodes.size();
+        return this->mParents.size();
     }
 
-    BurTree::~BurTree()
+    std::optional<double> BurTree::GetDistance(int index) const
     {
-        // delete index;
-        delete[] this->mData.ptr();
+        if (std::isnan(this->mDistances[index]))
+        {
+            return {};
+        }
+        return this->mDistances[index];
+    }
+
+    void BurTree::SetDistance(int index, double distance)
+    {
+        this->mDistances[index] = distance;
+    }
+
+    void BurTree::Save(const std::string &path, bool with_distances) const
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (!file.good())
+        {
+            throw std::runtime_error("Could not open " + path + " for writing the tree snapshot.");
+        }
+
+        // breadth-first from the root, so that parents precede their children also in a rerooted tree
+        int num_nodes = this->GetNumberOfNodes();
+        std::vector<int> first_child(num_nodes, -1);
+        std::vector<int> next_sibling(num_nodes, -1);
+        for (int i = num_nodes - 1; i >= 0; --i)
+        {
+            int parent = this->mParents[i];
+            if (parent != -1)
+            {
+                next_sibling[i] = first_child[parent];
+                first_child[parent] = i;
+            }
+        }
+
+        std::vector<int> order;
+        order.reserve(num_nodes);
+        order.push_back(this->GetRootIdx());
+        for (int n = 0; n < order.size(); ++n)
+        {
+            for (int child = first_child[order[n]]; child != -1; child = next_sibling[child])
+            {
+                order.push_back(child);
+            }
+        }
+
+        std::vector<int> new_index(num_nodes);
+        for (int n = 0; n < num_nodes; ++n)
+        {
+            new_index[order[n]] = n;
+        }
+
+        std::vector<double> configs(num_nodes * this->mQDim);
+        std::vector<double> distances(num_nodes);
+        std::vector<int32_t> parents(num_nodes);
+        for (int n = 0; n < num_nodes; ++n)
+        {
+            int node = order[n];
+            std::copy_n(this->mConfigs.data() + node * this->mQDim, this->mQDim, configs.data() + n * this->mQDim);
+            distances[n] = this->mDistances[node];
+            parents[n] = this->mParents[node] == -1 ? -1 : new_index[this->mParents[node]];
+        }
+
+        SnapshotHeader header;
+        std::memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+        header.version = kSnapshotVersion;
+        header.q_dim = this->mQDim;
+        header.flags = with_distances ? kSnapshotHasDistances : 0;
+        header.num_nodes = num_nodes;
+
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(configs.data()), configs.size() * sizeof(double));
+        if (with_distances)
+        {
+            file.write(reinterpret_cast<const char *>(distances.data()), distances.size() * sizeof(double));
+        }
+        file.write(reinterpret_cast<const char *>(parents.data()), parents.size() * sizeof(int32_t));
+
+        if (!file.good())
+        {
+            throw std::runtime_error("Failed to write the tree snapshot " + path);
+        }
+    }
+
+    std::shared_ptr<BurTree> BurTree::Load(const std::string &path, int q_dim, NNParams nn_params)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.good())
+        {
+            throw std::runtime_error("Could not open tree snapshot " + path);
+        }
+
+        size_t size = file.tellg();
+        SnapshotHeader header;
+        if (size < sizeof(header))
+        {
+            throw std::runtime_error("Tree snapshot " + path + " is too short.");
+        }
+        file.seekg(0);
+        file.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+        bool has_distances = header.flags & kSnapshotHasDistances;
+
+        // the dimension is checked before it enters the size, so that a corrupt header cannot overflow it
+        bool valid = std::memcmp(header.magic, kSnapshotMagic, sizeof(header.magic)) == 0 && header.version == kSnapshotVersion && header.q_dim > 0 && header.num_nodes >= 1;
+        size_t node_size = valid ? header.q_dim * sizeof(double) + sizeof(int32_t) + (has_distances ? sizeof(double) : 0) : 0;
+        valid = valid && header.num_nodes <= std::min<int64_t>((size - sizeof(header)) / node_size, std::numeric_limits<int>::max());
+        valid = valid && size == sizeof(header) + header.num_nodes * node_size;
+
+        if (!valid)
+        {
+            throw std::runtime_error("File " + path + " is not a valid tree snapshot.");
+        }
+        if (header.q_dim != q_dim)
+        {
+            throw std::runtime_error("Tree snapshot " + path + " has " + std::to_string(header.q_dim) + " joints instead of " + std::to_string(q_dim) + ".");
+        }
+
+        // the blocks are read straight into the tree storage, with the room a new tree starts out with
+        int num_nodes = header.num_nodes;
+        std::vector<double> configs;
+        configs.reserve(std::max(num_nodes, kInitialCapacity) * q_dim);
+        configs.resize(num_nodes * q_dim);
+        std::vector<double> distances(num_nodes, std::numeric_limits<double>::quiet_NaN());
+        std::vector<int> parents(num_nodes);
+
+        file.read(reinterpret_cast<char *>(configs.data()), configs.size() * sizeof(double));
+        if (has_distances)
+        {
+            file.read(reinterpret_cast<char *>(distances.data()), distances.size() * sizeof(double));
+        }
+        file.read(reinterpret_cast<char *>(parents.data()), parents.size() * sizeof(int32_t));
+
+        if (!file.good())
+        {
+            throw std::runtime_error("Failed to read the tree snapshot " + path);
+        }
+
+        // `Save` writes breadth-first: node 0 is the root and every other node hangs below an earlier one
+        bool is_tree = parents[0] == -1;
+        for (int i = 1; i < num_nodes && is_tree; ++i)
+        {
+            is_tree = parents[i] >= 0 && parents[i] < i;
+        }
+        if (!is_tree)
+        {
+            throw std::runtime_error("Tree snapshot " + path + " has invalid parents.");
+        }
+
+        return std::shared_ptr<BurTree>(new BurTree(q_dim, nn_params, std::move(configs), std::move(parents), std::move(distances)));
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,238 @@
+#include "bur_related/nn_backend.h"
+#include <limits>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace Burs
+{
+    /// @brief Batches with fewer query-row pairs than this are not worth spreading over threads
+    static constexpr long kParallelBatchWork = 1 << 16;
+
+    LinearNNBackend::LinearNNBackend(ConfigMetric metric)
+        : mMetric(metric)
+    {
+    }
+
+    double LinearNNBackend::SquaredDistance(const double *a, const double *b) const
+    {
+        double sum = 0.0;
+        int k = 0;
+#ifdef __AVX2__
+        const double *weights = this->mMetric.weights.data();
+        const double *wrap = this->mMetric.wrap.data();
+        const __m256d two_pi = _mm256_set1_pd(2.0 * M_PI);
+        const __m256d inv_two_pi = _mm256_set1_pd(0.5 / M_PI);
+        const __m256d zero = _mm256_setzero_pd();
+
+        __m256d acc = _mm256_setzero_pd();
+        for (; k + 4 <= this->mQDim; k += 4)
+        {
+            __m256d diff = _mm256_sub_pd(_mm256_loadu_pd(a + k), _mm256_loadu_pd(b + k));
+
+            __m256d turns = _mm256_round_pd(_mm256_mul_pd(diff, inv_two_pi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            __m256d wrapped = _mm256_sub_pd(diff, _mm256_mul_pd(turns, two_pi));
+            __m256d is_wrapped = _mm256_cmp_pd(_mm256_loadu_pd(wrap + k), zero, _CMP_NEQ_OQ);
+            diff = _mm256_mul_pd(_mm256_blendv_pd(diff, wrapped, is_wrapped), _mm256_loadu_pd(weights + k));
+
+            acc = _mm256_add_pd(acc, _mm256_mul_pd(diff, diff));
+        }
+        __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+        sum = _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+#endif
+        for (; k < this->mQDim; ++k)
+        {
+            double diff = this->mMetric.Difference(a[k], b[k], k);
+            sum += diff * diff;
+        }
+        return sum;
+    }
+
+    void LinearNNBackend::Build(const double *data, int num_rows, int q_dim)
+    {
+        this->mData = data;
+        this->mRows = num_rows;
+        this->mQDim = q_dim;
+    }
+
+    void LinearNNBackend::Extend(int num_rows)
+    {
+        this->mRows = num_rows;
+    }
+
+    int LinearNNBackend::Nearest(const double *q)
+    {
+        int closest_index = -1;
+        double closest_dist = std::numeric_limits<double>::infinity();
+
+        for (int i = 0; i < this->mRows; ++i)
+        {
+            double dist = this->SquaredDistance(this->mData + i * this->mQDim, q);
+            if (dist < closest_dist)
+            {
+                closest_dist = dist;
+                closest_index = i;
+            }
+        }
+        return closest_index;
+    }
+
+    void LinearNNBackend::NearestBatch(const double *queries, int num_queries, int *closest)
+    {
+#pragma omp parallel for if (num_queries * this->mRows > kParallelBatchWork)
+        for (int j = 0; j < num_queries; ++j)
+        {
+            closest[j] = this->Nearest(queries + j * this->mQDim);
+        }
+    }
+
+    void LinearNNBackend::KNearest(const double *q, int k, std::vector<int> &indices, std::vector<double> &dists)
+    {
+        k = std::min(k, this->mRows);
+        indices.clear();
+        dists.clear();
+
+        // insertion into the sorted k best, k is small
+        for (int i = 0; i < this->mRows; ++i)
+        {
+            double dist = this->SquaredDistance(this->mData + i * this->mQDim, q);
+            if ((int)dists.size() == k && dist >= dists.back())
+            {
+                continue;
+            }
+            if ((int)dists.size() == k)
+            {
+                dists.pop_back();
+                indices.pop_back();
+            }
+            auto pos = std::upper_bound(dists.begin(), dists.end(), dist);
+            indices.insert(indices.begin() + (pos - dists.begin()), i);
+            dists.insert(pos, dist);
+        }
+
+        for (double &dist : dists)
+        {
+            dist = std::sqrt(dist);
+        }
+    }
+
+    void LinearNNBackend::RadiusSearch(const double *q, double radius, std::vector<int> &indices, std::vector<double> &dists)
+    {
+        std::vector<int> found;
+        std::vector<double> found_dists;
+        for (int i = 0; i < this->mRows; ++i)
+        {
+            double dist = this->SquaredDistance(this->mData + i * this->mQDim, q);
+            if (dist <= radius * radius)
+            {
+                found.push_back(i);
+                found_dists.push_back(std::sqrt(dist));
+            }
+        }
+
+        std::vector<int> order(found.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](int a, int b)
+                  { return found_dists[a] < found_dists[b]; });
+
+        indices.resize(found.size());
+        dists.resize(found.size());
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            indices[i] = found[order[i]];
+            dists[i] = found_dists[order[i]];
+        }
+    }
+
+    FlannNNBackend::FlannNNBackend(ConfigMetric metric, int kd_trees, int search_checks, int search_cores)
+        : mMetric(metric), mKdTrees(kd_trees), mSearchChecks(search_checks), mSearchCores(search_cores)
+    {
+    }
+
+    void FlannNNBackend::Build(const double *data, int num_rows, int q_dim)
+    {
+        // FLANN only reads the data, but its matrix type is not const-correct
+        this->mData = const_cast<double *>(data);
+        this->mRows = num_rows;
+        this->mQDim = q_dim;
+
+        // FLANN keeps pointers to the rows, so only pass the rows that hold nodes
+        flann::Matrix<double> nodes_data(this->mData, num_rows, q_dim);
+        this->mIndex = std::make_unique<flann::Index<ConfigMetric>>(nodes_data, flann::KDTreeIndexParams(this->mKdTrees), this->mMetric);
+        this->mIndex->buildIndex();
+    }
+
+    void FlannNNBackend::Extend(int num_rows)
+    {
+        flann::Matrix<double> new_points(this->mData + this->mRows * this->mQDim, num_rows - this->mRows, this->mQDim);
+        this->mIndex->addPoints(new_points, kRebuildThreshold);
+        this->mRows = num_rows;
+    }
+
+    int FlannNNBackend::Nearest(const double *q)
+    {
+        this->mQuery.Reserve(1);
+
+        flann::Matrix<double> query(const_cast<double *>(q), 1, this->mQDim);
+        flann::Matrix<int> indices(this->mQuery.indices.data(), 1, 1);
+        flann::Matrix<double> dists(this->mQuery.dists.data(), 1, 1);
+
+        // Search for the closest point. We're only interested in the Nearest one.
+        this->mIndex->knnSearch(query, indices, dists, 1, flann::SearchParams(this->mSearchChecks));
+
+        return indices[0][0];
+    }
+
+    void FlannNNBackend::NearestBatch(const double *queries, int num_queries, int *closest)
+    {
+        this->mQuery.Reserve(num_queries);
+
+        flann::Matrix<double> query(const_cast<double *>(queries), num_queries, this->mQDim);
+        flann::Matrix<int> indices(closest, num_queries, 1);
+        flann::Matrix<double> dists(this->mQuery.dists.data(), num_queries, 1);
+
+        flann::SearchParams params(this->mSearchChecks);
+        // FLANN splits the queries over OpenMP threads
+        params.cores = this->mSearchCores;
+
+        this->mIndex->knnSearch(query, indices, dists, 1, params);
+    }
+
+    void FlannNNBackend::KNearest(const double *q, int k, std::vector<int> &indices, std::vector<double> &dists)
+    {
+        k = std::min(k, this->mRows);
+        indices.resize(k);
+        dists.resize(k);
+
+        flann::Matrix<double> query(const_cast<double *>(q), 1, this->mQDim);
+        flann::Matrix<int> indices_mtx(indices.data(), 1, k);
+        flann::Matrix<double> dists_mtx(dists.data(), 1, k);
+
+        this->mIndex->knnSearch(query, indices_mtx, dists_mtx, k, flann::SearchParams(this->mSearchChecks));
+
+        // ConfigMetric reports squared distances
+        for (double &dist : dists)
+        {
+            dist = std::sqrt(dist);
+        }
+    }
+
+    void FlannNNBackend::RadiusSearch(const double *q, double radius, std::vector<int> &indices, std::vector<double> &dists)
+    {
+        flann::Matrix<double> query(const_cast<double *>(q), 1, this->mQDim);
+
+        // ConfigMetric compares squared distances
+        this->mIndex->radiusSearch(query, this->mRadiusIndices, this->mRadiusDists, radius * radius, flann::SearchParams(this->mSearchChecks));
+
+        indices = this->mRadiusIndices[0];
+        dists.resize(indices.size());
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            dists[i] = std::sqrt(this->mRadiusDists[0][i]);
+        }
+    }
+}
@@ -16,8 +16,6 @@ namespace Burs
         int q_dim = this->GetNrOfJoints();
         std::cout << "Starting URDFPlanner..\n File: " << urdf_file << "\nq_dim: " << q_dim << std::endl;
 
-        ForwardKinematics fk = this->mCollisionEnv->myURDFRobot->GetForwardPointFunc();
-        RadiusFunc rf = this->mCollisionEnv->myURDFRobot->GetRadiusFunc();
         ForwardRt frt = this->mCollisionEnv->myURDFRobot->GetSelectedForwardRtFunc();
 
         std::vector<std::vector<double>> min_max_bounds = this->mCollisionEnv->myURDFRobot->GetMinMaxBounds();
@@ -37,10 +35,29 @@ namespace Burs
             }
         }
         // BasePlanner(int q_dim, ForwardKinematics f, int max_iters, double d_crit, double delta_q, double epsilon_q, MatrixXd bounds, RadiusFunc radius_func, int num_spikes);
-        this->mBasePlanner = std::make_shared<BasePlanner>(
-            q_dim, fk, max_iters, d_crit, delta_q, epsilon_q, minMaxBounds, rf, num_spikes);
+        // the common arms get configurations of fixed size, any other joint count plans with dynamic ones
+        switch (q_dim)
+        {
+        case 7:
+            this->mBasePlanner = std::make_shared<URDFBasePlannerT<7>>(
+                q_dim, this->mCollisionEnv->myURDFRobot, max_iters, d_crit, delta_q, epsilon_q, minMaxBounds, num_spikes);
+            break;
+        case 9:
+            this->mBasePlanner = std::make_shared<URDFBasePlannerT<9>>(
+                q_dim, this->mCollisionEnv->myURDFRobot, max_iters, d_crit, delta_q, epsilon_q, minMaxBounds, num_spikes);
+            break;
+        default:
+            this->mBasePlanner = std::make_shared<URDFBasePlannerT<Eigen::Dynamic>>(
+                q_dim, this->mCollisionEnv->myURDFRobot, max_iters, d_crit, delta_q, epsilon_q, minMaxBounds, num_spikes);
+        }
 
         this->mBasePlanner->SetBurEnv(this->mCollisionEnv);
+
+        // nearest neighbours by approximate workspace motion, measured around the middle of the joint ranges
+        NNParams nn_params;
+        nn_params.joint_weights = this->mCollisionEnv->myURDFRobot->GetJointWeights(minMaxBounds.rowwise().mean());
+        nn_params.continuous_joints = this->mCollisionEnv->myURDFRobot->GetContinuousJoints();
+        this->mBasePlanner->SetNNParams(nn_params);
     }
 
     unsigned int
@@ -57,6 +74,37 @@ namespace Burs
         return path_opt;
     }
 
+    void
+    URDFPlanner::SetUseRadiusBounds(bool use_radius_bounds)
+    {
+        if (use_radius_bounds)
+        {
+            this->mBasePlanner->SetRadiusBounds(this->mCollisionEnv->myURDFRobot->GetRadiusBounds());
+        }
+        else
+        {
+            this->mBasePlanner->SetRadiusBounds(std::nullopt);
+        }
+    }
+
+    void
+    URDFPlanner::SetDistanceCap(double distance_cap)
+    {
+        this->mBasePlanner->SetDistanceCap(distance_cap);
+    }
+
+    void
+    URDFPlanner::SetDistanceThreads(int distance_threads)
+    {
+        this->mCollisionEnv->SetDistanceThreads(distance_threads);
+    }
+
+    void
+    URDFPlanner::SetPerLinkClearance(bool per_link_clearance)
+    {
+        this->mBasePlanner->SetPerLinkClearance(per_link_clearance);
+    }
+
     int
     URDFPlanner::AddObstacle(std::string obstacle_file, Eigen::Matrix3d R, Eigen::Vector3d t)
     {
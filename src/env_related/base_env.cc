@@ -1,5 +1,8 @@
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <stdexcept>
+#include <tuple>
 #include "bur_related/burs.h"
 #include "model_related/rt_model.h"
 #include "PQP.h"
@@ -14,15 +17,39 @@ namespace Burs
     {
         auto [rotations, translations] = this->forwardRt(q);
 
+        this->robot_poses.resize(rotations.size());
         for (int i = 0; i < rotations.size(); ++i)
         {
             this->robot_models[i]->SetRotation(rotations[i]);
             this->robot_models[i]->SetTranslation(translations[i]);
+            // posed in place, so that the warm starts of the previous poses carry over
+            this->robot_models[i]->ComputePose(rotations[i], translations[i], this->robot_poses[i]);
+            this->robot_poses[i].warm_starts.resize(this->obstacle_models.size());
             // std::cout << "Setting robot position to " << translations[i].transpose() << std::endl;
         }
         this->poses_are_set = true;
     }
 
+    void
+    BaseEnv::ComputePoses(const VectorXd &q, std::vector<RtModels::RtPose> &robot_poses) const
+    {
+        auto [rotations, translations] = this->forwardRt(q);
+
+        robot_poses.resize(rotations.size());
+        for (int i = 0; i < rotations.size(); ++i)
+        {
+            this->robot_models[i]->ComputePose(rotations[i], translations[i], robot_poses[i]);
+            robot_poses[i].warm_starts.resize(this->obstacle_models.size());
+        }
+    }
+
+    RtModels::RtWarmStart *
+    BaseEnv::WarmStart(const std::vector<RtModels::RtPose> &robot_poses, int i, int k)
+    {
+        std::vector<RtModels::RtWarmStart> &warm_starts = robot_poses[i].warm_starts;
+        return k < warm_starts.size() ? &warm_starts[k] : nullptr;
+    }
+
     // void BaseEnv::SetObstaclePose(Matrix3d R, Vector3d t)
     // {
     //     for (int i = 0; i < rotations.size(); ++i)
@@ -35,67 +62,300 @@ namespace Burs
     // }
 
     bool
-    BaseEnv::IsColliding() const
+    BaseEnv::IsColliding(const std::vector<RtModels::RtPose> &robot_poses) const
     {
-        if (!this->poses_are_set)
+        PQP_CollideResult res;
+
+        // meshes with disjoint boxes cannot touch
+        for (auto [i, k] : this->GetCandidatePairs(robot_poses))
         {
-            std::runtime_error("Poses are not set. Set them before getting closest distance.\n");
+            RtModels::RtModel::Collide(&res, *this->robot_models[i], robot_poses[i], *this->obstacle_models[k], this->obstacle_models[k]->GetPose());
+
+            if (res.Colliding())
+            {
+                return true;
+            }
         }
+        return false;
+    }
 
-        double min_dist = 1e14;
+    bool
+    BaseEnv::IsWithinDistance(const std::vector<RtModels::RtPose> &robot_poses, double threshold) const
+    {
+        PQP_ToleranceResult res;
 
-        PQP_CollideResult res;
+        // meshes in boxes further apart than the threshold are further apart as well
+        for (auto [i, k] : this->GetCandidatePairs(robot_poses, threshold))
+        {
+            RtModels::RtModel::CheckTolerance(&res, threshold, *this->robot_models[i], robot_poses[i], *this->obstacle_models[k], this->obstacle_models[k]->GetPose());
 
-        for (int i = 0; i < this->robot_models.size(); i++)
+            if (res.CloserThanTolerance())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<std::pair<int, int>>
+    BaseEnv::GetCandidatePairs(const std::vector<RtModels::RtPose> &robot_poses, double margin) const
+    {
+        const int num_robot = this->robot_models.size();
+        auto box = [&](int id) -> const AlignedBox3d &
         {
-            std::shared_ptr<RtModels::RtModel> current_robot_part = this->robot_models[i];
-            for (int k = 0; k < this->obstacle_models.size(); k++)
+            return id < num_robot ? robot_poses[id].box : this->obstacle_models[id - num_robot]->GetPose().box;
+        };
+
+        // robot models first, then obstacles, ordered by the lower x of their boxes
+        std::vector<int> order(num_robot + this->obstacle_models.size());
+        for (int id = 0; id < order.size(); ++id)
+        {
+            order[id] = id;
+        }
+        std::sort(order.begin(), order.end(), [&](int a, int b)
+                  { return box(a).min().x() < box(b).min().x(); });
+
+        std::vector<std::pair<int, int>> pairs;
+        std::vector<int> open;
+        for (int id : order)
+        {
+            const AlignedBox3d &current = box(id);
+
+            // boxes ending before this one starts cannot overlap it or any later one
+            open.erase(std::remove_if(open.begin(), open.end(), [&](int other)
+                                      { return box(other).max().x() + margin < current.min().x(); }),
+                       open.end());
+
+            for (int other : open)
             {
-                auto obs = this->obstacle_models[k];
-                current_robot_part->Collide(&res, obs.get());
+                // only robot × obstacle pairs are of interest
+                if ((id < num_robot) == (other < num_robot))
+                {
+                    continue;
+                }
 
-                if (res.Colliding())
+                const AlignedBox3d &b = box(other);
+                if ((current.min().array() <= b.max().array() + margin).all() && (b.min().array() <= current.max().array() + margin).all())
                 {
-                    return true;
+                    pairs.emplace_back(std::min(id, other), std::max(id, other) - num_robot);
                 }
             }
+            open.push_back(id);
         }
-        return false;
+        return pairs;
     }
 
     double
-    BaseEnv::GetClosestDistance() const
+    BaseEnv::GetClosestDistance(const std::vector<RtModels::RtPose> &robot_poses, double cap) const
     {
-        if (!this->poses_are_set)
+        // (lower bound, robot model, obstacle model), the most promising pairs first
+        std::vector<std::tuple<double, int, int>> pairs;
+        pairs.reserve(this->robot_models.size() * this->obstacle_models.size());
+        for (int i = 0; i < this->robot_models.size(); i++)
         {
-            std::runtime_error("Poses are not set. Set them before getting closest distance.\n");
+            for (int k = 0; k < this->obstacle_models.size(); k++)
+            {
+                pairs.emplace_back(RtModels::RtModel::LowerBoundDistance(*this->robot_models[i], robot_poses[i], *this->obstacle_models[k], this->obstacle_models[k]->GetPose()), i, k);
+            }
+        }
+        std::sort(pairs.begin(), pairs.end());
+
+        if (this->distance_threads > 1 && pairs.size() > 1)
+        {
+            return this->GetClosestDistanceParallel(robot_poses, pairs, cap);
+        }
+
+        double min_dist = cap;
+
+        PQP_DistanceResult res;
+
+        for (auto [lower_bound, i, k] : pairs)
+        {
+            // every remaining pair is at least as far
+            if (lower_bound >= min_dist)
+            {
+                break;
+            }
+            RtModels::RtModel::CheckDistance(&res, 1e-3, 1e-3, *this->robot_models[i], robot_poses[i], *this->obstacle_models[k], this->obstacle_models[k]->GetPose(), WarmStart(robot_poses, i, k));
+
+            if (res.distance < min_dist)
+            {
+                min_dist = res.distance;
+            }
+        }
+        return min_dist;
+    }
+
+    double
+    BaseEnv::GetClosestDistanceParallel(const std::vector<RtModels::RtPose> &robot_poses, const std::vector<std::tuple<double, int, int>> &pairs, double cap) const
+    {
+        // pairs are handed out one at a time in lower bound order, a thread done with a cheap pair just takes the next one
+        std::atomic<int> next_pair(0);
+        std::atomic<double> min_dist(cap);
+
+#pragma omp parallel num_threads(std::min<int>(this->distance_threads, pairs.size()))
+        {
+            PQP_DistanceResult res;
+
+            for (int p = next_pair++; p < pairs.size(); p = next_pair++)
+            {
+                auto [lower_bound, i, k] = pairs[p];
+
+                // every later pair is at least as far, and a collision drops the minimum to 0 for all threads
+                if (lower_bound >= min_dist.load())
+                {
+                    break;
+                }
+                RtModels::RtModel::CheckDistance(&res, 1e-3, 1e-3, *this->robot_models[i], robot_poses[i], *this->obstacle_models[k], this->obstacle_models[k]->GetPose(), WarmStart(robot_poses, i, k));
+
+                double current = min_dist.load();
+                while (res.distance < current && !min_dist.compare_exchange_weak(current, res.distance))
+                {
+                }
+            }
         }
+        return min_dist.load();
+    }
 
-        double min_dist = 1e14;
+    VectorXd
+    BaseEnv::GetClosestDistances(const std::vector<RtModels::RtPose> &robot_poses, double cap) const
+    {
+        VectorXd distances = VectorXd::Constant(this->robot_models.size(), cap);
 
         PQP_DistanceResult res;
 
+        // (lower bound, obstacle model) of the current robot model
+        std::vector<std::pair<double, int>> obstacles(this->obstacle_models.size());
+
         for (int i = 0; i < this->robot_models.size(); i++)
         {
-            std::shared_ptr<RtModels::RtModel> current_robot_part = this->robot_models[i];
+            const RtModels::RtModel &current_robot_part = *this->robot_models[i];
             for (int k = 0; k < this->obstacle_models.size(); k++)
             {
-                auto obs = this->obstacle_models[k];
-                current_robot_part->CheckDistance(&res, 1e-3, 1e-3, obs.get());
+                obstacles[k] = {RtModels::RtModel::LowerBoundDistance(current_robot_part, robot_poses[i], *this->obstacle_models[k], this->obstacle_models[k]->GetPose()), k};
+            }
+            std::sort(obstacles.begin(), obstacles.end());
 
-                if (res.distance < min_dist)
+            for (auto [lower_bound, k] : obstacles)
+            {
+                if (lower_bound >= distances[i])
                 {
-                    min_dist = res.distance;
+                    break;
+                }
+                RtModels::RtModel::CheckDistance(&res, 1e-3, 1e-3, current_robot_part, robot_poses[i], *this->obstacle_models[k], this->obstacle_models[k]->GetPose(), WarmStart(robot_poses, i, k));
+
+                if (res.distance < distances[i])
+                {
+                    distances[i] = res.distance;
                 }
             }
         }
-        return min_dist;
+        return distances;
+    }
+
+    VectorXd
+    BaseEnv::GetPointClearances(const std::vector<RtModels::RtPose> &robot_poses, int num_points, double cap) const
+    {
+        VectorXd distances = this->GetClosestDistances(robot_poses, cap);
+        VectorXd clearances = VectorXd::Constant(num_points, cap);
+
+        for (int i = 0; i < distances.size(); i++)
+        {
+            int segment = this->robot_model_segments[i];
+            if (segment < 0)
+            {
+                clearances = clearances.cwiseMin(distances[i]);
+                continue;
+            }
+
+            // the mesh of a segment hangs between the joint that moves it and the next one,
+            // links past the last distal point (hand, fingers) are carried by that point
+            for (int point = segment + 1; point <= segment + 2; point++)
+            {
+                int bounded = std::min(point, num_points - 1);
+                clearances[bounded] = std::min(clearances[bounded], distances[i]);
+            }
+        }
+        return clearances;
+    }
+
+    bool
+    BaseEnv::IsColliding() const
+    {
+        if (!this->poses_are_set)
+        {
+            throw std::runtime_error("Poses are not set. Set them before getting closest distance.\n");
+        }
+
+        return this->IsColliding(this->robot_poses);
+    }
+
+    bool
+    BaseEnv::IsWithinDistance(double threshold) const
+    {
+        if (!this->poses_are_set)
+        {
+            throw std::runtime_error("Poses are not set. Set them before getting closest distance.\n");
+        }
+
+        return this->IsWithinDistance(this->robot_poses, threshold);
+    }
+
+    std::vector<std::pair<int, int>>
+    BaseEnv::GetCandidatePairs(double margin) const
+    {
+        if (!this->poses_are_set)
+        {
+            throw std::runtime_error("Poses are not set. Set them before getting closest distance.\n");
+        }
+
+        return this->GetCandidatePairs(this->robot_poses, margin);
+    }
+
+    double
+    BaseEnv::GetClosestDistance(double cap) const
+    {
+        if (!this->poses_are_set)
+        {
+            throw std::runtime_error("Poses are not set. Set them before getting closest distance.\n");
+        }
+
+        return this->GetClosestDistance(this->robot_poses, cap);
+    }
+
+    VectorXd
+    BaseEnv::GetClosestDistances(double cap) const
+    {
+        if (!this->poses_are_set)
+        {
+            throw std::runtime_error("Poses are not set. Set them before getting closest distance.\n");
+        }
+
+        return this->GetClosestDistances(this->robot_poses, cap);
+    }
+
+    VectorXd
+    BaseEnv::GetPointClearances(int num_points, double cap) const
+    {
+        if (!this->poses_are_set)
+        {
+            throw std::runtime_error("Poses are not set. Set them before getting closest distance.\n");
+        }
+
+        return this->GetPointClearances(this->robot_poses, num_points, cap);
     }
 
     void
-    BaseEnv::AddRobotModel(std::shared_ptr<RtModels::RtModel> m)
+    BaseEnv::AddRobotModel(std::shared_ptr<RtModels::RtModel> m, int segment_id)
     {
         this->robot_models.push_back(m);
+        this->robot_model_segments.push_back(segment_id);
+    }
+
+    void
+    BaseEnv::SetDistanceThreads(int distance_threads)
+    {
+        this->distance_threads = distance_threads;
     }
 
     void
@@ -11,9 +11,10 @@ namespace Burs
 
         std::cout << "CollisionEnv: Number of objects: " << mm.size() << std::endl;
 
-        for (auto &m : this->myURDFRobot->GetModels())
+        std::vector<int> segment_ids = this->myURDFRobot->GetModelSegmentIds();
+        for (int i = 0; i < mm.size(); ++i)
         {
-            this->AddRobotModel(m);
+            this->AddRobotModel(mm[i], segment_ids[i]);
         }
         this->AddForwardRt(this->myURDFRobot->GetSelectedForwardRtFunc());
     }
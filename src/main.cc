@@ -26,6 +26,8 @@ int main(int argc, char **argv)
         std::cout << "ARGUMENT 1 WAS TEST" << std::endl;
         // TODO: test: load test yaml or sth
         // test::test_forward(argc, argv);
+        test::test_tree_snapshot();
+        test::test_concurrent_queries();
         test::main_test();
         std::cout << "END TEST" << std::endl;
     }
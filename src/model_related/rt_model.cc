@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <functional>
 #include <iostream>
 #include <string>
 #include "model_related/rt_model.h"
@@ -27,6 +29,29 @@ namespace RtModels
         // Initialize class members they should auto-delete
         this->pqpModel = obj1;
 
+        // the bounding sphere is centred on the box, so both share one pass over the vertices
+        Eigen::AlignedBox3d local_box;
+        for (int i = 0; i < obj1->num_tris; ++i)
+        {
+            const Tri &tri = obj1->tris[i];
+            local_box.extend(Eigen::Vector3d(tri.p1[0], tri.p1[1], tri.p1[2]));
+            local_box.extend(Eigen::Vector3d(tri.p2[0], tri.p2[1], tri.p2[2]));
+            local_box.extend(Eigen::Vector3d(tri.p3[0], tri.p3[1], tri.p3[2]));
+        }
+        if (!local_box.isEmpty())
+        {
+            this->local_center = local_box.center();
+            this->local_half_extents = local_box.sizes() / 2;
+        }
+        for (int i = 0; i < obj1->num_tris; ++i)
+        {
+            const Tri &tri = obj1->tris[i];
+            for (const PQP_REAL *p : {tri.p1, tri.p2, tri.p3})
+            {
+                this->local_radius = std::max(this->local_radius, (Eigen::Vector3d(p[0], p[1], p[2]) - this->local_center).norm());
+            }
+        }
+
         this->SetRotation(Eigen::Matrix<PQP_REAL, 3, 3>::Identity()); // Initialized as identity matrix
         this->SetTranslation(Eigen::Vector3d::Zero());                // Initialized as zero vector
         std::cout << "RtModel: Loaded " << filePath << std::endl;
@@ -89,31 +114,31 @@ namespace RtModels
     PQP_REAL(*RtModel::getR())
     [3]
     {
-        return this->rotation;
+        return this->pose.rotation;
     }
 
     PQP_REAL *
     RtModel::getT()
     {
-        return this->translation;
+        return this->pose.translation;
     }
 
     void RtModel::Rotate(Eigen::Matrix<double, 3, 3> rotation)
     {
         this->R = rotation * this->R;
-        Eigen::Map<Eigen::Matrix<PQP_REAL, 3, 3, Eigen::RowMajor>>(this->rotation[0], 3, 3) = this->R;
+        this->ComputePose(this->R, this->t, this->pose);
     }
 
     void RtModel::SetRotation(Eigen::Matrix<double, 3, 3> rotation)
     {
         this->R = rotation;
-        Eigen::Map<Eigen::Matrix<PQP_REAL, 3, 3, Eigen::RowMajor>>(this->rotation[0], 3, 3) = this->R;
+        this->ComputePose(this->R, this->t, this->pose);
     }
 
     void RtModel::Translate(Eigen::Vector3d tr)
     {
         this->t = this->t + tr;
-        Eigen::Map<Eigen::Matrix<PQP_REAL, 3, 1>>(this->translation, 3) = this->t;
+        this->ComputePose(this->R, this->t, this->pose);
     }
 
     void RtModel::SetTranslation(Eigen::Vector3d tr)
@@ -121,8 +146,34 @@ namespace RtModels
         // std::cout << "INSIDE SET TRANSLATE: tr: " << tr.transpose() << std::endl;
         this->t = tr;
         // std::cout << "INSIDE SET TRANSLATE: this->t: " << this->t.transpose() << std::endl;
-        Eigen::Map<Eigen::Matrix<PQP_REAL, 3, 1>>(this->translation, 3) = this->t;
         // std::cout << "INSIDE SET TRANSLATE: this->translation: " << Vector3d(this->translation).transpose() << std::endl;
+        this->ComputePose(this->R, this->t, this->pose);
+    }
+
+    void RtModel::ComputePose(const Eigen::Matrix3d &rotation, const Eigen::Vector3d &tr, RtPose &pose) const
+    {
+        Eigen::Map<Eigen::Matrix<PQP_REAL, 3, 3, Eigen::RowMajor>>(pose.rotation[0], 3, 3) = rotation;
+        Eigen::Map<Eigen::Matrix<PQP_REAL, 3, 1>>(pose.translation, 3) = tr;
+
+        // a rotated box is enclosed by the box of half extents |R| h
+        Eigen::Vector3d half_extents = rotation.cwiseAbs() * this->local_half_extents;
+        pose.center = tr + rotation * this->local_center;
+        pose.box = Eigen::AlignedBox3d(pose.center - half_extents, pose.center + half_extents);
+    }
+
+    const RtPose &RtModel::GetPose() const
+    {
+        return this->pose;
+    }
+
+    double RtModel::LowerBoundDistance(const RtModel &m1, const RtPose &p1, const RtModel &m2, const RtPose &p2)
+    {
+        double sphere_distance = (p1.center - p2.center).norm() - m1.local_radius - m2.local_radius;
+
+        // per axis gap between the boxes, zero where they overlap
+        Eigen::Vector3d gap = (p1.box.min() - p2.box.max()).cwiseMax(p2.box.min() - p1.box.max()).cwiseMax(0.0);
+
+        return std::max({sphere_distance, gap.norm(), 0.0});
     }
 
     Eigen::Vector3d RtModel::GetGlobalPositionFromVector(Eigen::Vector3d p) const
@@ -136,6 +187,87 @@ namespace RtModels
         return this->t + this->R * pVector;
     }
 
+    namespace
+    {
+        /// @brief Copy of a shared PQP model for one query: shares its triangles and BVH, has its own warm-start triangle
+        /// PQP_Distance writes the closest triangle into the models it is given, with the copy the shared model stays untouched.
+        class QueryModel
+        {
+        public:
+            QueryModel(const PQP_Model &shared, const Tri *warm_start)
+            {
+                this->model.build_state = shared.build_state;
+                this->model.tris = shared.tris;
+                this->model.num_tris = shared.num_tris;
+                this->model.num_tris_alloced = shared.num_tris_alloced;
+                this->model.b = shared.b;
+                this->model.num_bvs = shared.num_bvs;
+                this->model.num_bvs_alloced = shared.num_bvs_alloced;
+
+                // a stale warm start, e.g. of a replaced obstacle, would give PQP an upper bound from another mesh
+                std::less<const Tri *> before;
+                bool own = warm_start && !before(warm_start, shared.tris) && before(warm_start, shared.tris + shared.num_tris);
+                this->model.last_tri = const_cast<Tri *>(own ? warm_start : shared.tris);
+            }
+
+            ~QueryModel()
+            {
+                // the arrays belong to the shared model, which frees them
+                this->model.tris = nullptr;
+                this->model.b = nullptr;
+            }
+
+            QueryModel(const QueryModel &) = delete;
+            QueryModel &operator=(const QueryModel &) = delete;
+
+            PQP_Model *Get()
+            {
+                return &this->model;
+            }
+
+            const Tri *LastTri() const
+            {
+                return this->model.last_tri;
+            }
+
+        private:
+            PQP_Model model;
+        };
+    }
+
+    // PQP takes its inputs by non-const pointers but only reads the poses
+    void RtModel::CheckDistance(PQP_DistanceResult *result, PQP_REAL rel_err, PQP_REAL abs_err, const RtModel &m1, const RtPose &p1, const RtModel &m2, const RtPose &p2, RtWarmStart *warm_start)
+    {
+        QueryModel q1(*m1.pqpModel, warm_start ? warm_start->tri1 : nullptr);
+        QueryModel q2(*m2.pqpModel, warm_start ? warm_start->tri2 : nullptr);
+
+        PQP_Distance(result, const_cast<PQP_REAL(*)[3]>(p1.rotation), const_cast<PQP_REAL *>(p1.translation), q1.Get(),
+                     const_cast<PQP_REAL(*)[3]>(p2.rotation), const_cast<PQP_REAL *>(p2.translation), q2.Get(), rel_err, abs_err);
+
+        if (warm_start)
+        {
+            *warm_start = {q1.LastTri(), q2.LastTri()};
+        }
+    }
+
+    void RtModel::Collide(PQP_CollideResult *result, const RtModel &m1, const RtPose &p1, const RtModel &m2, const RtPose &p2)
+    {
+        QueryModel q1(*m1.pqpModel, nullptr);
+        QueryModel q2(*m2.pqpModel, nullptr);
+
+        PQP_Collide(result, const_cast<PQP_REAL(*)[3]>(p1.rotation), const_cast<PQP_REAL *>(p1.translation), q1.Get(),
+                    const_cast<PQP_REAL(*)[3]>(p2.rotation), const_cast<PQP_REAL *>(p2.translation), q2.Get());
+    }
+
+    void RtModel::CheckTolerance(PQP_ToleranceResult *result, PQP_REAL tolerance, const RtModel &m1, const RtPose &p1, const RtModel &m2, const RtPose &p2)
+    {
+        QueryModel q1(*m1.pqpModel, nullptr);
+        QueryModel q2(*m2.pqpModel, nullptr);
+
+        PQP_Tolerance(result, const_cast<PQP_REAL(*)[3]>(p1.rotation), const_cast<PQP_REAL *>(p1.translation), q1.Get(),
+                      const_cast<PQP_REAL(*)[3]>(p2.rotation), const_cast<PQP_REAL *>(p2.translation), q2.Get(), tolerance);
+    }
+
     void RtModel::CheckDistanceStatic(PQP_DistanceResult *result, PQP_REAL rel_err, PQP_REAL abs_err, RtModel *m1, RtModel *m2)
     {
         PQP_Distance(result, m1->getR(), m1->getT(), m1->pqpModel.get(), m2->getR(), m2->getT(), m2->pqpModel.get(), rel_err, abs_err);
@@ -160,4 +292,9 @@ namespace RtModels
         PQP_Collide(result, this->getR(), this->getT(), this->pqpModel.get(), m2->getR(), m2->getT(), m2->pqpModel.get());
     }
 
+    void RtModel::CheckTolerance(PQP_ToleranceResult *result, PQP_REAL tolerance, RtModel *m2)
+    {
+        PQP_Tolerance(result, this->getR(), this->getT(), this->pqpModel.get(), m2->getR(), m2->getT(), m2->pqpModel.get(), tolerance);
+    }
+
 }
\ No newline at end of file
@@ -270,6 +270,94 @@ static PyObject *URDFPlanner_SetObstacleRotation(URDFPlannerObject *self, PyObje
     }
 }
 
+static PyObject *URDFPlanner_SetUseRadiusBounds(URDFPlannerObject *self, PyObject *args)
+{
+    int use_radius_bounds;
+
+    // Extract arguments from Python
+    if (!PyArg_ParseTuple(args, "p", &use_radius_bounds))
+    {
+        return NULL;
+    }
+
+    try
+    {
+        self->planner->SetUseRadiusBounds(use_radius_bounds);
+        Py_RETURN_NONE;
+    }
+    catch (const std::exception &e)
+    {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return NULL;
+    }
+}
+
+static PyObject *URDFPlanner_SetPerLinkClearance(URDFPlannerObject *self, PyObject *args)
+{
+    int per_link_clearance;
+
+    // Extract arguments from Python
+    if (!PyArg_ParseTuple(args, "p", &per_link_clearance))
+    {
+        return NULL;
+    }
+
+    try
+    {
+        self->planner->SetPerLinkClearance(per_link_clearance);
+        Py_RETURN_NONE;
+    }
+    catch (const std::exception &e)
+    {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return NULL;
+    }
+}
+
+static PyObject *URDFPlanner_SetDistanceCap(URDFPlannerObject *self, PyObject *args)
+{
+    double distance_cap;
+
+    // Extract arguments from Python
+    if (!PyArg_ParseTuple(args, "d", &distance_cap))
+    {
+        return NULL;
+    }
+
+    try
+    {
+        self->planner->SetDistanceCap(distance_cap);
+        Py_RETURN_NONE;
+    }
+    catch (const std::exception &e)
+    {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return NULL;
+    }
+}
+
+static PyObject *URDFPlanner_SetDistanceThreads(URDFPlannerObject *self, PyObject *args)
+{
+    int distance_threads;
+
+    // Extract arguments from Python
+    if (!PyArg_ParseTuple(args, "i", &distance_threads))
+    {
+        return NULL;
+    }
+
+    try
+    {
+        self->planner->SetDistanceThreads(distance_threads);
+        Py_RETURN_NONE;
+    }
+    catch (const std::exception &e)
+    {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return NULL;
+    }
+}
+
 static PyObject *URDFPlanner_ToString(URDFPlannerObject *self, PyObject *args)
 {
     PyObject *py_q_in;
@@ -335,6 +423,10 @@ static PyMethodDef URDFPlanner_methods[] = {
     {"PlanPath", (PyCFunction)URDFPlanner_PlanPath, METH_VARARGS, "Plan a path from start to goal."},
     {"AddObstacle", (PyCFunction)URDFPlanner_AddObstacle, METH_VARARGS, "Add an obstacle with file path, rotation matrix, and translation vector."},
     {"SetObstacleRotation", (PyCFunction)URDFPlanner_SetObstacleRotation, METH_VARARGS, "Set the rotation and translation of an obstacle."},
+    {"SetUseRadiusBounds", (PyCFunction)URDFPlanner_SetUseRadiusBounds, METH_VARARGS, "Build burs from precomputed radius bounds instead of iterating the kinematics."},
+    {"SetPerLinkClearance", (PyCFunction)URDFPlanner_SetPerLinkClearance, METH_VARARGS, "Bound every link's motion by its own obstacle distance instead of the global closest one."},
+    {"SetDistanceCap", (PyCFunction)URDFPlanner_SetDistanceCap, METH_VARARGS, "Report obstacle distances beyond the cap as the cap instead of resolving them."},
+    {"SetDistanceThreads", (PyCFunction)URDFPlanner_SetDistanceThreads, METH_VARARGS, "Evaluate the robot-obstacle distance pairs on this many threads."},
     {"ToString", (PyCFunction)URDFPlanner_ToString, METH_VARARGS, "Get a string representation of the planner state for a given configuration."},
     {"InterpolatePath", (PyCFunction)URDFPlanner_InterpolatePath, METH_VARARGS, "Interpolate a given path with a specified threshold."},
     {NULL, NULL, 0, NULL} /* Sentinel */
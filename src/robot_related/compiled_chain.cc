@@ -0,0 +1,275 @@
+#include <kdl/chain.hpp>
+#include <kdl/frames.hpp>
+
+#include "robot_related/compiled_chain.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace Burs
+{
+    static Eigen::Vector3d ToEigen(const KDL::Vector &v)
+    {
+        return Eigen::Vector3d(v.x(), v.y(), v.z());
+    }
+
+    static Eigen::Isometry3d ToEigen(const KDL::Frame &f)
+    {
+        Eigen::Isometry3d iso = Eigen::Isometry3d::Identity();
+        for (int j = 0; j < 3; ++j)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                iso.linear()(j, k) = f.M(j, k);
+            }
+        }
+        iso.translation() = ToEigen(f.p);
+        return iso;
+    }
+
+    /// @brief Number of configurations evaluated together by `ForwardPointsBatch`
+    static constexpr int kBatchLanes = 4;
+
+#ifdef __AVX2__
+    using Lanes = __m256d;
+
+    static inline Lanes Broadcast(double x) { return _mm256_set1_pd(x); }
+    static inline Lanes Load(const double *x) { return _mm256_loadu_pd(x); }
+    static inline void Store(double *x, Lanes a) { _mm256_storeu_pd(x, a); }
+    static inline Lanes Add(Lanes a, Lanes b) { return _mm256_add_pd(a, b); }
+    static inline Lanes Mul(Lanes a, Lanes b) { return _mm256_mul_pd(a, b); }
+    /// @brief a * b + c
+    static inline Lanes MulAdd(Lanes a, Lanes b, Lanes c) { return _mm256_fmadd_pd(a, b, c); }
+#else
+    struct Lanes
+    {
+        double v[kBatchLanes];
+    };
+
+    static inline Lanes Broadcast(double x) { return Lanes{{x, x, x, x}}; }
+    static inline Lanes Load(const double *x) { return Lanes{{x[0], x[1], x[2], x[3]}}; }
+    static inline void Store(double *x, Lanes a) { std::copy(a.v, a.v + kBatchLanes, x); }
+    static inline Lanes Add(Lanes a, Lanes b) { return Lanes{{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}}; }
+    static inline Lanes Mul(Lanes a, Lanes b) { return Lanes{{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}}; }
+    static inline Lanes MulAdd(Lanes a, Lanes b, Lanes c) { return Add(Mul(a, b), c); }
+#endif
+
+    /// @brief Rigid transform of every lane, rotation stored row-major
+    struct LaneFrame
+    {
+        Lanes R[9];
+        Lanes p[3];
+    };
+
+    /// @brief out = a * b, where the rotation of `b` is `b_R` and its translation `b_p`
+    static inline void Compose(const LaneFrame &a, const Lanes *b_R, const Lanes *b_p, LaneFrame &out)
+    {
+        for (int r = 0; r < 3; ++r)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                out.R[3 * r + c] = MulAdd(a.R[3 * r], b_R[c], MulAdd(a.R[3 * r + 1], b_R[3 + c], Mul(a.R[3 * r + 2], b_R[6 + c])));
+            }
+            out.p[r] = MulAdd(a.R[3 * r], b_p[0], MulAdd(a.R[3 * r + 1], b_p[1], MulAdd(a.R[3 * r + 2], b_p[2], a.p[r])));
+        }
+    }
+
+    CompiledChain::CompiledChain(const KDL::Chain &kdl_chain)
+    {
+        for (unsigned int i = 0; i < kdl_chain.getNrOfSegments(); ++i)
+        {
+            const KDL::Segment &kdl_segment = kdl_chain.getSegment(i);
+            const KDL::Joint &joint = kdl_segment.getJoint();
+
+            // KDL: segment.pose(q) = joint.pose(q) * f_tip and getFrameToTip() = joint.pose(0) * f_tip
+            KDL::Frame joint_zero = joint.pose(0.0);
+            KDL::Frame f_tip = joint_zero.Inverse() * kdl_segment.getFrameToTip();
+
+            CompiledSegment segment;
+            segment.axis = ToEigen(joint.JointAxis());
+            // the joint's rotation at q = 0 (its offset) is folded into the tip, only the translation stays in front of the motion
+            segment.origin = ToEigen(joint_zero.p);
+            segment.tip = ToEigen(KDL::Frame(joint_zero.M, KDL::Vector::Zero()) * f_tip);
+
+            switch (joint.getType())
+            {
+            case KDL::Joint::None:
+                segment.kind = JointKind::Fixed;
+                segment.joint_index = -1;
+                segment.origin.setZero();
+                segment.tip = ToEigen(kdl_segment.getFrameToTip());
+                break;
+            case KDL::Joint::TransAxis:
+            case KDL::Joint::TransX:
+            case KDL::Joint::TransY:
+            case KDL::Joint::TransZ:
+                segment.kind = JointKind::Prismatic;
+                segment.joint_index = this->num_joints++;
+                break;
+            default:
+                segment.kind = JointKind::Revolute;
+                segment.joint_index = this->num_joints++;
+                break;
+            }
+
+            this->segments.push_back(segment);
+        }
+    }
+
+    void CompiledChain::ForwardPointsBatch(const double *configs, int num_configs, int num_points, double *points) const
+    {
+        const int q_dim = this->num_joints;
+        const int num_segments = this->segments.size();
+
+        double q[kBatchLanes];
+        double c[kBatchLanes];
+        double s[kBatchLanes];
+        double out[kBatchLanes];
+
+        for (int first = 0; first < num_configs; first += kBatchLanes)
+        {
+            // the last block repeats its final configuration in the unused lanes
+            int width = std::min(kBatchLanes, num_configs - first);
+
+            LaneFrame frame;
+            LaneFrame next;
+            for (int k = 0; k < 9; ++k)
+            {
+                frame.R[k] = Broadcast(k % 4 == 0 ? 1.0 : 0.0);
+            }
+            for (int k = 0; k < 3; ++k)
+            {
+                frame.p[k] = Broadcast(0.0);
+            }
+
+            for (int i = 0; i < num_points; ++i)
+            {
+                for (int k = 0; k < 3; ++k)
+                {
+                    Store(out, frame.p[k]);
+                    for (int l = 0; l < width; ++l)
+                    {
+                        points[(size_t)(first + l) * 3 * num_points + 3 * i + k] = out[l];
+                    }
+                }
+
+                if (i >= num_segments || i + 1 == num_points)
+                {
+                    continue;
+                }
+
+                const CompiledSegment &segment = this->segments[i];
+
+                Lanes tip_R[9];
+                Lanes tip_p[3];
+                for (int r = 0; r < 3; ++r)
+                {
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        tip_R[3 * r + k] = Broadcast(segment.tip.linear()(r, k));
+                    }
+                    tip_p[r] = Broadcast(segment.tip.translation()(r));
+                }
+
+                if (segment.kind == JointKind::Fixed)
+                {
+                    Compose(frame, tip_R, tip_p, next);
+                    std::swap(frame, next);
+                    continue;
+                }
+
+                for (int l = 0; l < kBatchLanes; ++l)
+                {
+                    q[l] = configs[(size_t)(first + std::min(l, width - 1)) * q_dim + segment.joint_index];
+                }
+
+                Lanes local_R[9];
+                Lanes local_p[3];
+                const Eigen::Vector3d &a = segment.axis;
+
+                if (segment.kind == JointKind::Revolute)
+                {
+                    for (int l = 0; l < kBatchLanes; ++l)
+                    {
+                        c[l] = std::cos(q[l]);
+                        s[l] = std::sin(q[l]);
+                    }
+                    Lanes cos_q = Load(c);
+                    Lanes sin_q = Load(s);
+                    Lanes one_minus_cos = Add(Broadcast(1.0), Mul(Broadcast(-1.0), cos_q));
+
+                    // Rodrigues: R = cos I + sin [a]x + (1 - cos) a a^T
+                    const double cross[9] = {0.0, -a.z(), a.y(), a.z(), 0.0, -a.x(), -a.y(), a.x(), 0.0};
+                    Lanes rot[9];
+                    for (int r = 0; r < 3; ++r)
+                    {
+                        for (int k = 0; k < 3; ++k)
+                        {
+                            Lanes diagonal = r == k ? cos_q : Broadcast(0.0);
+                            rot[3 * r + k] = MulAdd(one_minus_cos, Broadcast(a(r) * a(k)), MulAdd(sin_q, Broadcast(cross[3 * r + k]), diagonal));
+                        }
+                    }
+
+                    // local = [rot | origin] * tip
+                    for (int r = 0; r < 3; ++r)
+                    {
+                        for (int k = 0; k < 3; ++k)
+                        {
+                            local_R[3 * r + k] = MulAdd(rot[3 * r], tip_R[k], MulAdd(rot[3 * r + 1], tip_R[3 + k], Mul(rot[3 * r + 2], tip_R[6 + k])));
+                        }
+                        local_p[r] = MulAdd(rot[3 * r], tip_p[0], MulAdd(rot[3 * r + 1], tip_p[1], MulAdd(rot[3 * r + 2], tip_p[2], Broadcast(segment.origin(r)))));
+                    }
+                }
+                else
+                {
+                    // local = [I | origin + q axis] * tip
+                    Lanes joint_q = Load(q);
+                    for (int r = 0; r < 3; ++r)
+                    {
+                        for (int k = 0; k < 3; ++k)
+                        {
+                            local_R[3 * r + k] = tip_R[3 * r + k];
+                        }
+                        local_p[r] = MulAdd(joint_q, Broadcast(a(r)), Add(tip_p[r], Broadcast(segment.origin(r))));
+                    }
+                }
+
+                Compose(frame, local_R, local_p, next);
+                std::swap(frame, next);
+            }
+        }
+    }
+
+    Eigen::VectorXd CompiledChain::RadiusBounds(const Eigen::VectorXd &max_travel) const
+    {
+        const int num_segments = this->segments.size();
+
+        // reach[i] bounds the distance from the frame of segment i to the end of the chain
+        Eigen::VectorXd reach = Eigen::VectorXd::Zero(num_segments + 1);
+        for (int i = num_segments - 1; i >= 0; --i)
+        {
+            const CompiledSegment &segment = this->segments[i];
+            double length = segment.tip.translation().norm() + segment.origin.norm();
+            if (segment.kind == JointKind::Prismatic)
+            {
+                length += max_travel(segment.joint_index);
+            }
+            reach(i) = reach(i + 1) + length;
+        }
+
+        Eigen::VectorXd bounds = Eigen::VectorXd::Zero(this->num_joints);
+        for (int i = 0; i < num_segments; ++i)
+        {
+            const CompiledSegment &segment = this->segments[i];
+            if (segment.kind != JointKind::Fixed)
+            {
+                // a prismatic joint moves everything behind it by exactly its own displacement
+                bounds(segment.joint_index) = segment.kind == JointKind::Prismatic ? 1.0 : reach(i);
+            }
+        }
+        return bounds;
+    }
+}
@@ -64,8 +64,7 @@ namespace Burs
 
         this->minMaxBounds = this->GetMinMaxBounds();
 
-        // this->fk_solver = std::make_shared<KDL::ChainFkSolverPos_recursive>(kdl_chain);
-        // this->fk_solver = this->GetFKSolver(this->kdl_chain);
+        this->compiled_chain = CompiledChain(this->kdl_chain);
 
         // KDL::ChainFkSolverPos_recursive fk_solver = GetFKSolver(this->kdl_chain);
 
@@ -118,8 +117,14 @@ namespace Burs
             auto joint = this->robot_model->getJoint(name);
             if (joint && joint->type != urdf::Joint::UNKNOWN && joint->type != urdf::Joint::FIXED)
             {
-                double lower_limit = joint->limits->lower;
-                double upper_limit = joint->limits->upper;
+                // continuous joints may come without limits, one full turn covers them
+                double lower_limit = joint->limits ? joint->limits->lower : -M_PI;
+                double upper_limit = joint->limits ? joint->limits->upper : M_PI;
+                if (joint->type == urdf::Joint::CONTINUOUS && lower_limit == upper_limit)
+                {
+                    lower_limit = -M_PI;
+                    upper_limit = M_PI;
+                }
                 // Use the joint limits here
                 minmaxs[num_joints][0] = lower_limit;
                 minmaxs[num_joints][1] = upper_limit;
@@ -136,6 +141,55 @@ namespace Burs
         return minmaxs;
     }
 
+    std::vector<bool>
+    RobotBase::GetContinuousJoints()
+    {
+        std::vector<bool> continuous;
+        for (int i = 0; i < kdl_chain.getNrOfSegments(); ++i)
+        {
+            const KDL::Joint &joint = kdl_chain.getSegment(i).getJoint();
+
+            if (joint.getType() != KDL::Joint::None)
+            {
+                auto urdf_joint = this->robot_model->getJoint(joint.getName());
+                continuous.push_back(urdf_joint && urdf_joint->type == urdf::Joint::CONTINUOUS);
+            }
+        }
+        return continuous;
+    }
+
+    std::vector<double>
+    RobotBase::GetJointWeights(const Eigen::VectorXd &q_in)
+    {
+        // joints turning about the end-effector would otherwise not count at all
+        const double min_weight = 0.05;
+
+        Eigen::VectorXd radii(kdl_chain.getNrOfSegments());
+        this->GetRadii(q_in, radii);
+
+        std::vector<double> weights;
+        for (int i = 0; i < kdl_chain.getNrOfSegments(); ++i)
+        {
+            const KDL::Joint &joint = kdl_chain.getSegment(i).getJoint();
+
+            switch (joint.getType())
+            {
+            case KDL::Joint::None:
+                break;
+            case KDL::Joint::TransAxis:
+            case KDL::Joint::TransX:
+            case KDL::Joint::TransY:
+            case KDL::Joint::TransZ:
+                weights.push_back(1.0);
+                break;
+            default:
+                weights.push_back(std::max(radii(i), min_weight));
+                break;
+            }
+        }
+        return weights;
+    }
+
     std::optional<urdf::ModelInterfaceSharedPtr>
     RobotBase::GetRobotURDF(std::string urdf_filename)
     {
@@ -301,169 +355,89 @@ namespace Burs
     std::tuple<std::vector<Eigen::Matrix3d>, std::vector<Eigen::Vector3d>>
     RobotBase::ForwardQ(const Eigen::VectorXd &q_in)
     {
-        KDL::ChainFkSolverPos_recursive fk_solver(this->kdl_chain);
-
-        // Convert Eigen vector to KDL joint array
-        unsigned int num_joints = this->kdl_chain.getNrOfJoints();
-
-        assert(num_joints == q_in.size());
-
-        KDL::JntArray joint_positions(num_joints);
-        for (unsigned int i = 0; i < joint_positions.data.size(); ++i)
-        {
-            joint_positions(i) = q_in(i);
-        }
-
-        // Prepare the output vectors for rotations and positions
         std::vector<Eigen::Matrix3d> rotations;
         std::vector<Eigen::Vector3d> positions;
 
-        // Compute forward kinematics for all segments
-        for (unsigned int i = 0; i < this->kdl_chain.getNrOfSegments(); ++i)
-        {
-            KDL::Frame segment_pose;
-            if (fk_solver.JntToCart(joint_positions, segment_pose, i + 1) >= 0)
-            {
-                // Convert KDL rotation to Eigen matrix
-                Eigen::Matrix3d rotation;
-                for (int j = 0; j < 3; ++j)
-                {
-                    for (int k = 0; k < 3; ++k)
-                    {
-                        rotation(j, k) = segment_pose.M(j, k);
-                    }
-                }
-                rotations.push_back(rotation);
-
-                // Convert KDL position to Eigen vector
-                Eigen::Vector3d position(segment_pose.p.x(), segment_pose.p.y(), segment_pose.p.z());
-                // std::cout << "Segment " << i << ": " << position.transpose() << std::endl;
-                positions.push_back(position);
-            }
-            else
-            {
-                // Handle the error case if FK solver failed
-                // Depending on how you want to handle errors, you might throw an exception
-                // or handle it in some other way
-                // std::cout << "segment pose: " << segment_pose << std::endl;
-                throw std::runtime_error("Forward kinematics solver failed at segment " + std::to_string(i));
-            }
-        }
+        this->ForwardQ(q_in, rotations, positions);
 
         // Return the tuple of rotations and positions
         return std::make_tuple(rotations, positions);
     }
 
-    // using ForwardKinematics = std::function<Vector3d(const int &ith_distal_point, const VectorXd &configuration)>;
-    Eigen::Vector3d
-    RobotBase::GetForwardPoint(const int &ith_distal_point, const Eigen::VectorXd &q_in)
+    void
+    RobotBase::ForwardQ(const Eigen::VectorXd &q_in, std::vector<Eigen::Matrix3d> &rotations, std::vector<Eigen::Vector3d> &positions)
     {
-        KDL::ChainFkSolverPos_recursive fk_solver(this->kdl_chain);
-        // Convert Eigen vector to KDL joint array
-        size_t num_joints = this->kdl_chain.getNrOfJoints();
+        unsigned int num_segments = this->compiled_chain.GetNrOfSegments();
+
+        assert(this->compiled_chain.GetNrOfJoints() == q_in.size());
 
-        assert(q_in.size() == num_joints);
+        // every segment frame from a single traversal instead of one traversal per segment;
+        // the scratch is per thread so that pose updates of concurrent queries do not share it
+        thread_local std::vector<Eigen::Isometry3d> segment_frames;
+        this->compiled_chain.Forward(q_in, segment_frames);
 
-        KDL::JntArray joint_positions(num_joints);
+        rotations.resize(num_segments);
+        positions.resize(num_segments);
 
-        // theoretically don't need the joint angles after (i+1)
-        for (unsigned int i = 0; i < num_joints; ++i)
+        for (unsigned int i = 0; i < num_segments; ++i)
         {
-            joint_positions(i) = q_in(i);
+            rotations[i] = segment_frames[i + 1].linear();
+            positions[i] = segment_frames[i + 1].translation();
         }
+    }
 
-        KDL::Frame segment_pose;
-        if (fk_solver.JntToCart(joint_positions, segment_pose, ith_distal_point) >= 0)
-        {
+    // using ForwardKinematics = std::function<Vector3d(const int &ith_distal_point, const VectorXd &configuration)>;
+    Eigen::Vector3d
+    RobotBase::GetForwardPoint(const int &ith_distal_point, const Eigen::Ref<const Eigen::VectorXd> &q_in)
+    {
+        assert(q_in.size() == this->compiled_chain.GetNrOfJoints());
 
-            // Convert KDL position to Eigen vector
-            Eigen::Vector3d position(segment_pose.p.x(), segment_pose.p.y(), segment_pose.p.z());
-            // std::cout << "Forward point " << ith_distal_point << ": " << position.transpose() << std::endl;
-            return position;
-        }
-        else
+        if (ith_distal_point < 0 || ith_distal_point > this->compiled_chain.GetNrOfSegments())
         {
-            // Handle the error case if FK solver failed
-            // Depending on how you want to handle errors, you might throw an exception
-            // or handle it in some other way
-            // std::cout << "segment pose: " << segment_pose << std::endl;
             throw std::runtime_error("Forward kinematics solver failed at segment " + std::to_string(ith_distal_point));
         }
-    }
 
-    ForwardKinematics RobotBase::GetForwardPointFunc()
-    {
-        ForwardKinematics fpf = [this](const int &ith_distal_point, const VectorXd &configuration) -> Vector3d
-        {
-            return this->GetForwardPoint(ith_distal_point, configuration);
-        };
-        return fpf;
+        return this->compiled_chain.ForwardPoint(ith_distal_point, q_in);
     }
 
-    double
-    RobotBase::GetRadius(const int &ith_distal_point, const Eigen::VectorXd &q_in)
+    void
+    RobotBase::GetForwardPointsBatch(const Eigen::Ref<const Eigen::MatrixXd> &configurations, Eigen::MatrixXd &points)
     {
-        KDL::ChainFkSolverPos_recursive fk_solver(this->kdl_chain);
-
-        size_t num_joints = this->kdl_chain.getNrOfJoints();
-
-        assert(q_in.size() == num_joints);
+        // the kernel walks the configurations with a stride of one column
+        assert(configurations.outerStride() == configurations.rows());
+        assert(configurations.rows() == this->compiled_chain.GetNrOfJoints());
+        assert(points.cols() == configurations.cols() && points.rows() % 3 == 0);
 
-        KDL::JntArray joint_positions(num_joints);
-
-        for (unsigned int i = 0; i < num_joints; ++i)
+        int num_points = points.rows() / 3;
+        if (num_points > this->compiled_chain.GetNrOfSegments() + 1)
         {
-            joint_positions(i) = q_in(i);
+            throw std::runtime_error("Forward kinematics solver failed at segment " + std::to_string(num_points - 1));
         }
 
-        KDL::Frame segment_pose;
-        if (fk_solver.JntToCart(joint_positions, segment_pose, ith_distal_point) >= 0)
-        {
-            Eigen::Vector3d position(segment_pose.p.x(), segment_pose.p.y(), segment_pose.p.z());
-            // std::cout << "GetRadius position: " << position.transpose() << std::endl;
-
-            KDL::Vector joint_axis_local = this->kdl_chain.getSegment(ith_distal_point).getJoint().JointAxis();
-
-            KDL::Frame end_effector_pose;
-            if (fk_solver.JntToCart(joint_positions, end_effector_pose) >= 0)
-            {
-                KDL::Vector end_effector_kdl = end_effector_pose.p;
-                Eigen::Vector3d end_effector(end_effector_kdl.x(), end_effector_kdl.y(), end_effector_kdl.z());
-
-                // Transform the local joint axis to the world reference frame
-                KDL::Vector joint_axis_world = segment_pose.M * joint_axis_local;
-                // std::cout << "GetRadius axis: " << joint_axis_world << std::endl;
-                Eigen::Vector3d joint_axis(joint_axis_world.x(), joint_axis_world.y(), joint_axis_world.z());
-
-                Eigen::Vector3d diff = end_effector - position;
-                // Project the end effector onto the plane defined by the joint axis
-                double dot_product = diff.dot(joint_axis);
-                // joint_axis has norm = 1 => NO NORMALIZATION NECESSARY
-                Eigen::Vector3d projection = diff - dot_product * joint_axis;
+        this->compiled_chain.ForwardPointsBatch(configurations.data(), configurations.cols(), num_points, points.data());
+    }
 
-                // Return the norm (distance) of the projection
+    double
+    RobotBase::GetRadius(const int &ith_distal_point, const Eigen::Ref<const Eigen::VectorXd> &q_in)
+    {
+        assert(q_in.size() == this->compiled_chain.GetNrOfJoints());
 
-                // std::cout << "Radius distance " << ith_distal_point << ": " << projection.norm() << std::endl;
-                return projection.norm();
-            }
-            else
-            {
-                throw std::runtime_error("Failed to calculate end-effector pose for radius calculation.");
-            }
-        }
-        else
+        if (ith_distal_point < 0 || ith_distal_point > this->compiled_chain.GetNrOfSegments())
         {
             throw std::runtime_error("Forward kinematics solver failed at segment " + std::to_string(ith_distal_point));
         }
+
+        return this->compiled_chain.Radius(ith_distal_point, q_in);
     }
 
-    RadiusFunc
-    RobotBase::GetRadiusFunc()
+    Eigen::VectorXd
+    RobotBase::GetRadiusBounds()
     {
-        RadiusFunc rf = [this](const int &ith_distal_point, const VectorXd &configuration) -> double
+        Eigen::VectorXd max_travel(this->minMaxBounds.size());
+        for (size_t i = 0; i < this->minMaxBounds.size(); ++i)
         {
-            return this->GetRadius(ith_distal_point, configuration);
-        };
-        return rf;
+            max_travel(i) = std::max(std::abs(this->minMaxBounds[i][0]), std::abs(this->minMaxBounds[i][1]));
+        }
+        return this->compiled_chain.RadiusBounds(max_travel);
     }
-}
\ No newline at end of file
+}
@@ -42,11 +42,11 @@ namespace Burs
     std::tuple<std::vector<Matrix3d>, std::vector<Vector3d>>
     RobotCollision::SelectedForwardQ(const VectorXd &q_in)
     {
+        // reused for the poses of all segments, per thread so that concurrent queries can pose the robot
+        thread_local std::vector<Matrix3d> rawRotations;
+        thread_local std::vector<Vector3d> rawTranslations;
 
-        std::tuple<std::vector<Matrix3d>, std::vector<Vector3d>> rawRts = this->ForwardQ(q_in);
-
-        std::vector<Matrix3d> rawRotations = std::get<0>(rawRts);
-        std::vector<Vector3d> rawTranslations = std::get<1>(rawRts);
+        this->ForwardQ(q_in, rawRotations, rawTranslations);
 
         std::vector<Matrix3d> Rs(this->numberOfModels);
         std::vector<Vector3d> ts(this->numberOfModels);
@@ -94,4 +94,18 @@ namespace Burs
         }
         return models;
     }
+
+    std::vector<int>
+    RobotCollision::GetModelSegmentIds()
+    {
+        std::vector<int> segment_ids;
+        for (int i = 0; i < this->segmentIdToModel.size(); ++i)
+        {
+            if (this->segmentIdToModel[i])
+            {
+                segment_ids.push_back(i);
+            }
+        }
+        return segment_ids;
+    }
 }